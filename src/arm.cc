@@ -4,11 +4,22 @@
 
 void Arm::reset() {
 	all.clear();
+	schedule.clear();
 }
 
 void Arm::tick() {
-	for (auto& arm: all) {
+	for (uint id: schedule.ready(Sim::tick)) {
+		if (!all.has(id)) continue;
+		Arm& arm = get(id);
 		arm.update();
+
+		Entity& en = Entity::get(id);
+		if (en.isGhost() || !en.isEnabled()) {
+			schedule.sleep(id);
+		} else
+		if (arm.pause > Sim::tick) {
+			schedule.sleep(id, arm.pause);
+		}
 	}
 }
 
@@ -23,6 +34,7 @@ Arm& Arm::create(uint id) {
 	arm.outputStoreId = 0;
 	arm.stage = Input;
 	arm.orientation = 0.0f;
+	schedule.insert(id);
 	return arm;
 }
 
@@ -31,6 +43,7 @@ Arm& Arm::get(uint id) {
 }
 
 void Arm::destroy() {
+	schedule.remove(id);
 	all.erase(id);
 }
 
@@ -347,6 +360,7 @@ void Arm::update() {
 	if (en.isGhost()) return;
 	if (!en.isEnabled()) return;
 	if (pause > Sim::tick) return;
+	en.changed(Save::Section::Arms);
 
 	uint maxState = en.spec->states.size()-1;
 	ensure(maxState > 360);
@@ -356,6 +370,14 @@ void Arm::update() {
 			en.state = maxState;
 			if (updateReady()) {
 				stage = Unparking;
+			} else
+			if (inputId && outputId && !Entity::get(inputId).spec->conveyor && !Entity::get(outputId).spec->conveyor) {
+				// between two stores nothing changes until either does, so
+				// sleep until Store::changed() wakes us, with a slow poll for
+				// neighbours being built or the stores' levels shifting
+				schedule.watch(id, inputId);
+				schedule.watch(id, outputId);
+				schedule.sleep(id, Sim::tick+60);
 			} else {
 				pause = Sim::tick+10;
 			}
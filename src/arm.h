@@ -5,6 +5,7 @@
 struct Arm;
 
 #include "slabmap.h"
+#include "wake-queue.h"
 #include "miniset.h"
 #include "item.h"
 #include "entity.h"
@@ -18,6 +19,7 @@ struct Arm {
 	static void loadAll(const char* name);
 
 	static inline slabmap<Arm,&Arm::id> all;
+	static inline WakeQueue schedule;
 	static Arm& create(uint id);
 	static Arm& get(uint id);
 
@@ -32,9 +34,9 @@ struct Arm {
 	};
 
 	uint iid;
-	uint inputId;
+	slabhandle<uint> inputId;
 	uint inputStoreId;
-	uint outputId;
+	slabhandle<uint> outputId;
 	uint outputStoreId;
 	float orientation;
 	enum Stage stage;
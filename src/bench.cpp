@@ -0,0 +1,194 @@
+// Headless benchmark. Loads a save and runs the simulation for a number of
+// ticks without a window or GL context, then reports per-system tick timings
+// from the Sim::stats* TimeSeries as CSV or JSON.
+//
+//   ./factropy-bench [--ticks N] [--threads N] [--regions] [--json] [--out file] [save]
+
+#include "common.h"
+#include "mod.h"
+#include "sim.h"
+#include "entity.h"
+#include "scenario.h"
+#include "jobs.h"
+#include "path.h"
+#include "json.hpp"
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+
+using json = nlohmann::json;
+
+struct Sampler {
+	const char* name;
+	TimeSeries* series;
+	std::vector<double> samples;
+
+	double min() {
+		return samples.size() ? *std::min_element(samples.begin(), samples.end()): 0.0;
+	}
+
+	double max() {
+		return samples.size() ? *std::max_element(samples.begin(), samples.end()): 0.0;
+	}
+
+	double mean() {
+		double sum = 0.0;
+		for (double s: samples) sum += s;
+		return samples.size() ? sum/(double)samples.size(): 0.0;
+	}
+
+	double percentile(double p) {
+		if (!samples.size()) return 0.0;
+		std::vector<double> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		uint i = (uint)std::ceil(p * (double)sorted.size()) - 1;
+		return sorted[std::min(i, (uint)sorted.size()-1)];
+	}
+};
+
+int main(int argc, char const *argv[]) {
+	std::string save = "autosave";
+	std::string out;
+	uint64_t ticks = 3600;
+	bool asJson = false;
+	uint threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	for (int i = 1; i < argc; i++) {
+		auto arg = std::string(argv[i]);
+
+		if (arg == "--ticks" && i+1 < argc) {
+			ticks = std::max(1, std::atoi(argv[++i]));
+			continue;
+		}
+
+		if (arg == "--regions") {
+			Sim::regions = true;
+			continue;
+		}
+
+		if (arg == "--threads" && i+1 < argc) {
+			threads = std::max(0, std::atoi(argv[++i]));
+			continue;
+		}
+
+		if (arg == "--json") {
+			asJson = true;
+			continue;
+		}
+
+		if (arg == "--csv") {
+			asJson = false;
+			continue;
+		}
+
+		if (arg == "--out" && i+1 < argc) {
+			out = argv[++i];
+			continue;
+		}
+
+		if (arg.size() && arg[0] != '-') {
+			save = arg;
+			continue;
+		}
+
+		fatalf("unexpected argument: %s", arg.c_str());
+	}
+
+	if (!std::filesystem::exists(save)) {
+		fatalf("save not found: %s", save.c_str());
+	}
+
+	rlHeadless = true;
+	Jobs::start(threads);
+
+	// one round of path slices per tick, so runs are comparable
+	Path::budget = 0;
+
+	Mod* mod = new ModDuktape("base");
+	mod->load();
+
+	scenario();
+
+	Sim::load(save.c_str());
+
+	std::vector<Sampler> samplers = {
+		{ "Entity", &Sim::statsEntity },
+		{ "Ghost", &Sim::statsGhost },
+		{ "Pipe", &Sim::statsPipe },
+		{ "Store", &Sim::statsStore },
+		{ "Arm", &Sim::statsArm },
+		{ "Crafter", &Sim::statsCrafter },
+		{ "Projector", &Sim::statsProjector },
+		{ "Path", &Sim::statsPath },
+		{ "Vehicle", &Sim::statsVehicle },
+		{ "Conveyor", &Sim::statsConveyor },
+		{ "Unveyor", &Sim::statsUnveyor },
+		{ "Loader", &Sim::statsLoader },
+		{ "Ropeway", &Sim::statsRopeway },
+		{ "RopewayBucket", &Sim::statsRopewayBucket },
+		{ "Depot", &Sim::statsDepot },
+		{ "Drone", &Sim::statsDrone },
+		{ "Missile", &Sim::statsMissile },
+		{ "Explosion", &Sim::statsExplosion },
+		{ "Turret", &Sim::statsTurret },
+		{ "Computer", &Sim::statsComputer },
+	};
+
+	Sampler total = { "Total", nullptr };
+
+	for (auto& sampler: samplers) {
+		sampler.samples.reserve(ticks);
+	}
+	total.samples.reserve(ticks);
+
+	notef("%s: %u entities, running %lu ticks on %u workers", save.c_str(), Entity::all.size(), ticks, Jobs::workers());
+
+	for (uint64_t i = 0; i < ticks; i++) {
+		Sim::update();
+		mod->update();
+
+		double sum = 0.0;
+		for (auto& sampler: samplers) {
+			double ms = sampler.series->ticks[TimeSeries::tick(Sim::tick)];
+			sampler.samples.push_back(ms);
+			sum += ms;
+		}
+		total.samples.push_back(sum);
+	}
+
+	samplers.push_back(total);
+
+	std::ofstream file;
+	if (out.size()) {
+		file.open(out);
+	}
+	std::ostream& os = out.size() ? file: std::cout;
+
+	if (asJson) {
+		json state;
+		state["save"] = save;
+		state["ticks"] = ticks;
+		for (auto& sampler: samplers) {
+			json system;
+			system["min"] = sampler.min();
+			system["mean"] = sampler.mean();
+			system["p99"] = sampler.percentile(0.99);
+			system["max"] = sampler.max();
+			state["systems"][sampler.name] = system;
+		}
+		os << state.dump(2) << "\n";
+	}
+	else {
+		os << "system,min_ms,mean_ms,p99_ms,max_ms\n";
+		for (auto& sampler: samplers) {
+			os << fmt("%s,%0.4f,%0.4f,%0.4f,%0.4f\n",
+				sampler.name, sampler.min(), sampler.mean(), sampler.percentile(0.99), sampler.max()
+			);
+		}
+	}
+
+	delete mod;
+	Jobs::stop();
+	return 0;
+}
@@ -40,5 +40,6 @@ Energy Burner::consume(Energy e) {
 	}
 	Energy c = energy < e ? energy: e;
 	energy = std::max(Energy(0), energy-c);
+	if (c) Entity::get(id).changed(Save::Section::Burners);
 	return c;
 }
@@ -3,6 +3,8 @@
 #include "point.h"
 #include "part.h"
 #include "sim.h"
+#include "path-graph.h"
+#include <limits>
 
 Chunk::Chunk(int cx, int cy) {
 	meshMutex.lock();
@@ -13,6 +15,8 @@ Chunk::Chunk(int cx, int cy) {
 	ZERO(heightmap);
 	ZERO(newHeightmap);
 	ZERO(tiles);
+	ZERO(edited);
+	unsaved = true;
 	generated = false;
 	meshReady = false;
 	meshLoaded = false;
@@ -70,6 +74,13 @@ Chunk* Chunk::Tile::chunk() {
 	return tryGet(cx, cy);
 }
 
+void Chunk::Tile::edit() {
+	auto [ox, oy] = Chunk::tileXYtoOffsetXY(x, y);
+	Chunk* c = chunk();
+	c->edited[oy][ox] = true;
+	c->unsaved = true;
+}
+
 void Chunk::generator(Chunk::Generator fn) {
 	generators.push_back(fn);
 }
@@ -141,54 +152,63 @@ Chunk::Tile* Chunk::tileTryGet(Point p) {
 	return tileTryGet(x, y);
 }
 
-void Chunk::generate() {
-	notef("generate %d %d (%lu)", x, y, all.size());
+// Terrain and resources for one tile straight from the noise, as generate()
+// makes it before any mining or flattening. Depends only on Sim::seed and
+// Item::mining, so saves can store just the differences.
+Chunk::Tile Chunk::generateTile(int tx, int ty) {
+	//float elevation = (float)Sim::noise2D(x*size+tx, y*size+ty, 8, 0.5, 0.007) - 0.5f; // -0.5->0.5
+	float elevation = (float)Sim::noise2D(x*size+tx, y*size+ty, 8, 0.5, 0.008) - 0.5f; // -0.5->0.5
 
-	for (int ty = 0; ty < size; ty++) {
-		for (int tx = 0; tx < size; tx++) {
+	elevation += 0.1;
 
-			//float elevation = (float)Sim::noise2D(x*size+tx, y*size+ty, 8, 0.5, 0.007) - 0.5f; // -0.5->0.5
-			float elevation = (float)Sim::noise2D(x*size+tx, y*size+ty, 8, 0.5, 0.008) - 0.5f; // -0.5->0.5
+	// floodplain
+	if (elevation > 0.0f) {
+		if (elevation < 0.3f) {
+			elevation = 0.0f;
+		} else {
+			elevation -= 0.3f;
+		}
+	}
 
-			elevation += 0.1;
+	double offset = 1000000;
 
-			// floodplain
-			if (elevation > 0.0f) {
-				if (elevation < 0.3f) {
-					elevation = 0.0f;
-				} else {
-					elevation -= 0.3f;
-				}
-			}
+	uint mineral = 0;
+	float resource = 0.0f;
+
+	// layer once used for the mesh mineral hint, see generate()
+	offset += 1000000;
 
-			double offset = 1000000;
+	for (auto iid: Item::mining) {
+		//float density = (float)Sim::noise2D(x*size+tx+offset, y*size+ty+offset, 8, 0.5, 0.007);
+		float density = (float)Sim::noise2D(x*size+tx+offset, y*size+ty+offset, 8, 0.4, 0.005);
+		if (density > resource) {
+			mineral = iid;
+			resource = density;
+		}
+		offset += 1000000;
+	}
 
-			uint mineral = 0;
-			float resource = 0.0f;
+	return (Tile){
+		.x = x*size+tx,
+		.y = y*size+ty,
+		.hill = nullptr,
+		.elevation = elevation,
+		.mineral = {mineral, (uint)(resource*100.0f)},
+	};
+}
+
+void Chunk::generate() {
+	notef("generate %d %d (%lu)", x, y, all.size());
 
+	for (int ty = 0; ty < size; ty++) {
+		for (int tx = 0; tx < size; tx++) {
 			float hint = Sim::random(); //(float)Sim::noise2D(x*size+tx+offset, y*size+ty+offset, 8, 0.6, 0.3);
-			offset += 1000000;
-
-			for (auto iid: Item::mining) {
-				//float density = (float)Sim::noise2D(x*size+tx+offset, y*size+ty+offset, 8, 0.5, 0.007);
-				float density = (float)Sim::noise2D(x*size+tx+offset, y*size+ty+offset, 8, 0.4, 0.005);
-				if (density > resource) {
-					mineral = iid;
-					resource = density;
-				}
-				offset += 1000000;
-			}
 
-			tiles[ty][tx] = (Tile){
-				.x = x*size+tx,
-				.y = y*size+ty,
-				.hill = nullptr,
-				.elevation = elevation,
-				.mineral = {mineral, (uint)(resource*100.0f)},
-			};
+			Tile* tile = &tiles[ty][tx];
+			*tile = generateTile(tx, ty);
 
 			// minables visible on hills
-			if (elevation > 0.01f && mineral != 0 && hint > 0.99) {
+			if (tile->elevation > 0.01f && tile->mineral.iid != 0 && hint > 0.99) {
 				meshMinerals.push_back({tx,ty});
 			}
 		}
@@ -268,6 +288,7 @@ Stack Chunk::mine(Box b, uint iid) {
 				for (auto tile: hill->tiles) {
 					if (tile->mineral.iid == iid && tile->mineral.size > 0) {
 						tile->mineral.size -= 1;
+						tile->edit();
 						break;
 					}
 				}
@@ -305,9 +326,164 @@ void Chunk::flatten(Box b) {
 		Tile *tile = tileTryGet(x, y);
 		if (tile && tile->elevation > 0.0f) {
 			tile->elevation = 0.0f;
+			tile->edit();
 			tile->chunk()->regenerate();
 		}
 	}
+	for (auto xy: gridwalk(size, b)) {
+		auto it = rasters.find(xy);
+		if (it != rasters.end()) {
+			it->second->classed = false;
+		}
+	}
+	PathGraph::invalidate(b);
+}
+
+namespace {
+	// Visit the raster byte of each tile overlapping b, stopping early if
+	// fn returns false. Tiles without a raster are skipped unless create.
+	template <typename F>
+	bool rasterEach(Box b, bool create, F fn) {
+		int size = Chunk::size;
+		gridwalk::iterator tiles(1, b);
+
+		if (tiles.cx1 <= tiles.cx0 || tiles.cy1 <= tiles.cy0) return true;
+
+		auto [cx0,cz0] = Chunk::tileXYtoChunkXY(tiles.cx0, tiles.cy0);
+		auto [cx1,cz1] = Chunk::tileXYtoChunkXY(tiles.cx1-1, tiles.cy1-1);
+
+		for (int cz = cz0; cz <= cz1; cz++) {
+			for (int cx = cx0; cx <= cx1; cx++) {
+				Chunk::Raster* raster = nullptr;
+				if (create) {
+					raster = Chunk::raster({cx,cz});
+				} else {
+					auto it = Chunk::rasters.find({cx,cz});
+					if (it == Chunk::rasters.end()) continue;
+					raster = it->second;
+				}
+
+				int x0 = std::max(tiles.cx0, cx*size);
+				int z0 = std::max(tiles.cy0, cz*size);
+				int x1 = std::min(tiles.cx1, (cx+1)*size);
+				int z1 = std::min(tiles.cy1, (cz+1)*size);
+
+				for (int z = z0; z < z1; z++) {
+					for (int x = x0; x < x1; x++) {
+						if (!fn(raster, raster->tiles[(z-cz*size)*size + (x-cx*size)])) return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// so bounds and queries meeting exactly on a tile edge, or with no
+	// width at all, still share a tile
+	Box padded(Box b) {
+		return b.grow(0.01f);
+	}
+
+	void classify(Chunk::Raster* raster) {
+		Chunk* chunk = Chunk::tryGet(raster->xy.x, raster->xy.y);
+		if (!chunk) return;
+
+		for (int z = 0; z < Chunk::size; z++) {
+			for (int x = 0; x < Chunk::size; x++) {
+				Chunk::Tile& tile = chunk->tiles[z][x];
+				uint8_t& t = raster->tiles[z*Chunk::size+x];
+				uint8_t c = tile.isWater() ? Chunk::Raster::Water: (tile.isHill() ? Chunk::Raster::Hill: Chunk::Raster::Land);
+				t = (t & Chunk::Raster::Full) | c;
+			}
+		}
+		raster->classed = true;
+	}
+}
+
+Chunk::Raster* Chunk::raster(XY xy) {
+	auto it = rasters.find(xy);
+	if (it != rasters.end()) return it->second;
+	Raster* raster = new Raster;
+	raster->xy = xy;
+	rasters[xy] = raster;
+	return raster;
+}
+
+void Chunk::occupy(Box b) {
+	rasterEach(padded(b), true, [](Raster*, uint8_t& t) {
+		if ((t & Raster::Full) != Raster::Full) t += Raster::One;
+		return true;
+	});
+}
+
+void Chunk::vacate(Box b) {
+	rasterEach(padded(b), false, [](Raster*, uint8_t& t) {
+		uint8_t n = t & Raster::Full;
+		if (n && n != Raster::Full) t -= Raster::One;
+		return true;
+	});
+}
+
+// True when no indexed entity's bounds can intersect b
+bool Chunk::vacant(Box b) {
+	return rasterEach(padded(b), false, [](Raster*, uint8_t& t) {
+		return !(t & Raster::Full);
+	});
+}
+
+// Walks the tiles a line from a to b crosses (Amanatides-Woo), checking each
+// grown by clearance. Ignores height, so it's a conservative filter for
+// Sim::rayCast style collision tests.
+bool Chunk::vacantLine(Point a, Point b, float clearance) {
+	float inf = std::numeric_limits<float>::infinity();
+
+	int x = std::floor(a.x);
+	int z = std::floor(a.z);
+	int xe = std::floor(b.x);
+	int ze = std::floor(b.z);
+
+	float dx = b.x-a.x;
+	float dz = b.z-a.z;
+	int sx = dx > 0 ? 1: -1;
+	int sz = dz > 0 ? 1: -1;
+
+	float tdx = dx != 0.0f ? std::abs(1.0f/dx): inf;
+	float tdz = dz != 0.0f ? std::abs(1.0f/dz): inf;
+	float tmx = dx != 0.0f ? (sx > 0 ? (x+1)-a.x: a.x-x) * tdx: inf;
+	float tmz = dz != 0.0f ? (sz > 0 ? (z+1)-a.z: a.z-z) * tdz: inf;
+
+	// float error can't add more steps than this
+	int steps = std::abs(xe-x) + std::abs(ze-z);
+
+	for (int i = 0; i <= steps; i++) {
+		if (!vacant(Point(x, 0, z).tileCentroid().box().grow(clearance + 0.5f))) {
+			return false;
+		}
+		if (tmx < tmz) {
+			tmx += tdx;
+			x += sx;
+		} else {
+			tmz += tdz;
+			z += sz;
+		}
+	}
+	return true;
+}
+
+// Raster class of a tile, or Unknown if its chunk isn't generated
+uint8_t Chunk::terrain(int x, int y) {
+	Raster* r = raster(tileXYtoChunkXY(x, y));
+	if (!r->classed) classify(r);
+	auto [ox,oy] = tileXYtoOffsetXY(x, y);
+	return r->tiles[oy*size+ox] & Raster::Class;
+}
+
+// Chunk::isLand, but reading classes from the rasters instead of the tiles
+bool Chunk::isLandRaster(Box b) {
+	return rasterEach(b, true, [](Raster* r, uint8_t& t) {
+		if (!r->classed) classify(r);
+		return (t & Raster::Class) == Raster::Land;
+	});
 }
 
 std::vector<Stack> Chunk::minables(Box b) {
@@ -331,8 +507,13 @@ void Chunk::reset() {
 	for (auto hill: hills) {
 		delete hill;
 	}
+	for (auto& [_,raster]: rasters) {
+		delete raster;
+	}
 	all.clear();
 	hills.clear();
+	rasters.clear();
+	PathGraph::reset();
 }
 
 void Chunk::terrainNormals() {
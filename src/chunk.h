@@ -39,6 +39,7 @@ struct Chunk {
 		Stack mineral;
 
 		Chunk* chunk();
+		void edit();
 		bool isLand();
 		bool isWater();
 		bool isHill();
@@ -46,6 +47,37 @@ struct Chunk {
 
 	static inline Chunk* lastChunk = nullptr;
 
+	// A byte per tile: terrain class in the low two bits and, above them, a
+	// count of indexed entities whose bounds cover the tile, mirroring
+	// Entity::grid at tile resolution. Entity::index/unindex keep the counts
+	// current, so ray casts and path-finding can step over empty ground
+	// without spatial queries. Counts stick once saturated, which only ever
+	// makes a tile look busier than it is. Rasters are kept apart from the
+	// chunks so they exist before a chunk is generated; written on the sim
+	// thread only, and safe to read from parallel phases.
+	struct Raster {
+		static const uint8_t Unknown = 0;
+		static const uint8_t Land = 1;
+		static const uint8_t Water = 2;
+		static const uint8_t Hill = 3;
+		static const uint8_t Class = 3;
+		static const uint8_t One = 4;
+		static const uint8_t Full = 0xfc;
+
+		XY xy;
+		bool classed = false;
+		uint8_t tiles[size*size] = {};
+	};
+
+	static inline std::map<XY,Raster*> rasters;
+	static Raster* raster(XY xy);
+	static void occupy(Box b);
+	static void vacate(Box b);
+	static bool vacant(Box b);
+	static bool vacantLine(Point a, Point b, float clearance);
+	static uint8_t terrain(int x, int y);
+	static bool isLandRaster(Box b);
+
 	static XY tileXYtoChunkXY(int x, int y);
 	static XY tileXYtoOffsetXY(int x, int y);
 
@@ -62,6 +94,7 @@ struct Chunk {
 	static Chunk* tryGet(int x, int y);
 	static Chunk* tryGet(Point p);
 	void generate();
+	Tile generateTile(int tx, int ty);
 	static Chunk* request(int x, int y);
 	static Chunk::Tile* tileTryGet(int x, int y);
 	static Chunk::Tile* tileTryGet(Point p);
@@ -84,6 +117,10 @@ struct Chunk {
 
 	int x, y;
 	Tile tiles[size][size];
+	// tiles mined or flattened since generation; saves store only these
+	bool edited[size][size];
+	// generated or edited since the last save, for the journal
+	bool unsaved;
 
 	std::mutex meshMutex;
 	Mesh heightmap;
@@ -1,117 +1,251 @@
 #include "common.h"
 #include "sim.h"
 #include "conveyor.h"
+#include "chunk.h"
+#include "jobs.h"
 
 void Conveyor::reset() {
 	all.clear();
+	belts.clear();
+	orphans.clear();
+	regions.clear();
+	boundary.clear();
+	regroup = true;
+	rebuild = true;
+}
+
+void Conveyor::wake(Belt* belt) {
+	if (!belt) return;
+	belt->awake = true;
+	belt->unsaved = true;
+	for (uint feeder: belt->feeders) {
+		auto it = belts.find(feeder);
+		if (it != belts.end()) it->second.awake = true;
+	}
+}
+
+// Hand a belt's unsaved flag to its segments' entities for the next save
+void Conveyor::changed(Belt* belt) {
+	if (!belt || !belt->unsaved) return;
+	belt->unsaved = false;
+	for (auto segment: belt->segments) {
+		Entity::get(segment->id).changed(Save::Section::Conveyors);
+	}
+}
+
+void Conveyor::dissolve(Belt* belt) {
+	if (!belt) return;
+	changed(belt);
+
+	Conveyor* leader = belt->segments.front();
+	if (leader->cside && leader->cside->belt) {
+		discard_if(leader->cside->belt->feeders, [&](uint fid) { return fid == leader->id; });
+	}
+
+	for (auto segment: belt->segments) {
+		segment->belt = nullptr;
+		orphans.insert(segment->id);
+	}
+
+	belts.erase(leader->id);
+	regroup = true;
+}
+
+// Walk downstream from any member to find the belt leader: the end of a
+// straight line, or the lowest id on a loop. Then materialize the line.
+void Conveyor::assemble(uint id) {
+	Conveyor* start = &get(id);
+	Conveyor* leader = start;
+	bool circular = false;
+
+	for (Conveyor* c = start; c->next; ) {
+		c = &get(c->next);
+		if (c == start) {
+			circular = true;
+			break;
+		}
+		if (!circular) leader = c;
+	}
+
+	if (circular) {
+		for (Conveyor* c = &get(start->next); c != start; c = &get(c->next)) {
+			if (c->id < leader->id) leader = c;
+		}
+	}
+
+	ensure(!belts.count(leader->id));
+	Belt& belt = belts[leader->id];
+	belt.circular = circular;
+
+	leader->cnext = nullptr;
+	leader->cprev = leader->prev ? &get(leader->prev): nullptr;
+	leader->cside = !circular && leader->side ? &get(leader->side): nullptr;
+	ensure(!circular || !leader->side);
+
+	uint prev = leader->prev;
+	while (prev && prev != leader->id) {
+		Conveyor& before = get(prev);
+		ensure(before.managed);
+		before.cnext = before.next ? &get(before.next): nullptr;
+		before.cprev = before.prev ? &get(before.prev): nullptr;
+		ensure(!before.side);
+		before.cside = nullptr;
+		prev = before.prev;
+	}
+
+	if (circular) {
+		get(leader->next).cprev = nullptr;
+	}
+
+	for (Conveyor* c = leader; c; c = c->cprev) {
+		ensure(!c->belt);
+		c->belt = &belt;
+		belt.segments.push_back(c);
+	}
+
+	belt.contained = true;
+	for (auto segment: belt.segments) {
+		Point pos = Entity::get(segment->id).pos;
+		auto chunk = Chunk::tileXYtoChunkXY(std::floor(pos.x), std::floor(pos.z));
+		if (segment == leader) belt.chunk = chunk;
+		belt.contained = belt.contained && chunk == belt.chunk;
+	}
+	regroup = true;
+
+	// register with the belt we sideload onto
+	if (leader->cside && leader->cside->belt) {
+		leader->cside->belt->feeders.push_back(leader->id);
+	}
+
+	// find belts that sideload onto us
+	for (auto segment: belt.segments) {
+		Entity& en = Entity::get(segment->id);
+		Entity::forEachIntersecting(en.box().grow(0.5), [&](uint oid) {
+			if (oid == segment->id || !all.has(oid)) return;
+			Conveyor& co = get(oid);
+			if (co.side == segment->id && co.belt && co.belt->segments.front() == &co) {
+				belt.feeders.push_back(co.id);
+			}
+		});
+	}
 }
 
 void Conveyor::tick() {
 	if (rebuild) {
 		rebuild = false;
 
-		leadersStraight.clear();
-		leadersCircular.clear();
+		belts.clear();
+		orphans.clear();
+		regroup = true;
 		for (auto& conveyor: all) {
-			conveyor.marked = false;
 			conveyor.managed = !Entity::get(conveyor.id).isGhost();
+			conveyor.belt = nullptr;
+			if (conveyor.managed) orphans.insert(conveyor.id);
 		}
+	}
 
-		// identify belt leaders
-		for (auto& leader: all) {
-			if (!leader.managed) continue;
-
-			if (!leader.next) {
-				leadersStraight.push_back(leader.id);
-				leader.marked = true;
-				uint prev = leader.prev;
-				while (prev) {
-					Conveyor& before = get(prev);
-					ensure(!before.marked);
-					before.marked = true;
-					prev = before.prev;
-				}
-			}
-		}
+	for (uint id: orphans) {
+		if (!all.has(id)) continue;
+		Conveyor& conveyor = get(id);
+		if (!conveyor.managed || conveyor.belt) continue;
+		assemble(id);
+	}
+	orphans.clear();
 
-		for (auto& leader: all) {
-			if (!leader.managed) continue;
-
-			if (!leader.marked) {
-				ensure(leader.next && leader.prev);
-				leadersCircular.push_back(leader.id);
-				leader.marked = true;
-				uint prev = leader.prev;
-				while (prev) {
-					Conveyor& before = get(prev);
-					ensure(before.next && before.prev);
-					if (before.marked) break;
-					before.marked = true;
-					prev = before.prev;
-				}
-			}
-		}
+	if (Sim::regions) {
+		if (regroup) group();
 
-		for (auto id: leadersStraight) {
-			Conveyor& leader = get(id);
-			leader.cnext = nullptr;
-			leader.cprev = leader.prev ? &all[leader.prev]: nullptr;
-			leader.cside = leader.side ? &all[leader.side]: nullptr;
-			uint prev = leader.prev;
-			while (prev) {
-				Conveyor& before = get(prev);
-				before.cnext = before.next ? &all[before.next]: nullptr;
-				before.cprev = before.prev ? &all[before.prev]: nullptr;
-				ensure(!before.side);
-				before.cside = nullptr;
-				prev = before.prev;
+		Jobs::parallel(regions.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				for (auto belt: regions[i]) advance(*belt);
 			}
+		});
+
+		for (auto belt: boundary) {
+			advance(*belt);
 		}
+		return;
+	}
 
-		for (auto id: leadersCircular) {
-			Conveyor& leader = get(id);
-			leader.cnext = nullptr;
-			leader.cprev = leader.prev ? &all[leader.prev]: nullptr;
-			ensure(!leader.side);
-			leader.cside = nullptr;
-			uint prev = leader.prev;
-			while (prev && prev != leader.id) {
-				Conveyor& before = get(prev);
-				before.cnext = before.next ? &all[before.next]: nullptr;
-				before.cprev = before.prev ? &all[before.prev]: nullptr;
-				ensure(!before.side);
-				before.cside = nullptr;
-				prev = before.prev;
-			}
-			get(leader.next).cprev = nullptr;
+	// straight belts tick before circular belts
+	for (bool circular: {false, true}) {
+		for (auto& [_,belt]: belts) {
+			if (belt.circular != circular) continue;
+			advance(belt);
 		}
 	}
+}
+
+void Conveyor::advance(Belt& belt) {
+	if (!belt.awake) return;
+
+	bool moved = false;
+	Conveyor& leader = *belt.segments.front();
+
+	if (belt.circular && leader.iid && leader.offset == 0) {
+		uint iid = leader.iid;
+		leader.iid = 0;
+		for (auto segment: belt.segments) segment->update();
+		get(leader.next).deliver(iid);
+		moved = true;
+	}
+	else
+	if (belt.circular && leader.iid && leader.offset > 0) {
+		uint iid = leader.iid;
+		uint offset = leader.offset;
+		leader.iid = 0;
+		leader.offset = 0;
+		for (auto segment: belt.segments) segment->update();
+		leader.iid = iid;
+		leader.offset = offset-1;
+		moved = true;
+	}
+	else {
+		for (auto segment: belt.segments) moved = segment->update() || moved;
+	}
 
-	for (auto id: leadersStraight) {
-		Conveyor& leader = get(id);
-		leader.update();
+	if (moved) {
+		wake(&belt);
 	}
 
-	for (auto id: leadersCircular) {
-		Conveyor& leader = get(id);
-		if (leader.iid && leader.offset == 0) {
-			uint iid = leader.iid;
-			leader.iid = 0;
-			leader.update();
-			get(leader.next).deliver(iid);
-			continue;
-		}
-		if (leader.iid && leader.offset > 0) {
-			uint iid = leader.iid;
-			uint offset = leader.offset;
-			leader.iid = 0;
-			leader.offset = 0;
-			leader.update();
-			leader.iid = iid;
-			leader.offset = offset-1;
-			continue;
+	// a belt sideloading onto an unmanaged conveyor can't be woken by
+	// it, so never let it sleep
+	bool sleepy = !leader.cside || leader.cside->belt;
+	belt.awake = moved || !sleepy;
+}
+
+// Bucket belts by Chunk for region mode. A belt is local to a chunk when all
+// its segments and the whole belt it sideloads onto lie inside it; then every
+// conveyor it can touch, and every feeder it can wake, is only reachable
+// from that chunk's job. Everything else ticks serially in the boundary pass
+// afterwards. Order within each bucket is straight-then-circular by leader
+// id, so results don't depend on the number of workers.
+void Conveyor::group() {
+	regroup = false;
+	regions.clear();
+	boundary.clear();
+
+	std::map<gridwalk::xy,uint> index;
+
+	for (bool circular: {false, true}) {
+		for (auto& [_,belt]: belts) {
+			if (belt.circular != circular) continue;
+
+			Conveyor* side = belt.segments.front()->cside;
+			bool local = belt.contained
+				&& (!side || (side->belt && side->belt->contained && side->belt->chunk == belt.chunk));
+
+			if (!local) {
+				boundary.push_back(&belt);
+				continue;
+			}
+
+			if (!index.count(belt.chunk)) {
+				index[belt.chunk] = regions.size();
+				regions.push_back({});
+			}
+			regions[index[belt.chunk]].push_back(&belt);
 		}
-		leader.update();
 	}
 }
 
@@ -127,8 +261,8 @@ Conveyor& Conveyor::create(uint id) {
 	conveyor.side = 0;
 	conveyor.cnext = nullptr;
 	conveyor.cprev = nullptr;
-	conveyor.marked = false;
 	conveyor.managed = false;
+	conveyor.belt = nullptr;
 	return conveyor;
 }
 
@@ -160,11 +294,13 @@ Point Conveyor::output() {
 Conveyor& Conveyor::manage() {
 	ensure(!prev);
 	ensure(!next);
+	ensure(!belt);
 
-	rebuild = true;
 	managed = true;
+	orphans.insert(id);
 
 	Entity& en = Entity::get(id);
+	en.changed(Save::Section::Conveyors);
 
 	Box ib = input().box().grow(0.1f);
 	Box ob = output().box().grow(0.1f);
@@ -177,8 +313,10 @@ Conveyor& Conveyor::manage() {
 			Conveyor& co = eo.conveyor();
 			if (en.box().contains(co.input())) {
 				ensure(!co.prev);
+				dissolve(co.belt);
 				co.prev = id;
 				next = oid;
+				eo.changed(Save::Section::Conveyors);
 				break;
 			}
 		}
@@ -192,8 +330,10 @@ Conveyor& Conveyor::manage() {
 			Conveyor& ci = ei.conveyor();
 			if (en.box().contains(ci.output())) {
 				ensure(!ci.next);
+				dissolve(ci.belt);
 				ci.next = id;
 				prev = oid;
+				ei.changed(Save::Section::Conveyors);
 				break;
 			}
 		}
@@ -209,7 +349,9 @@ Conveyor& Conveyor::manage() {
 			Conveyor& co = eo.conveyor();
 			if (en.box().contains(co.output())) {
 				ensure(!co.side);
+				dissolve(co.belt);
 				co.side = id;
+				eo.changed(Save::Section::Conveyors);
 			}
 		}
 	}
@@ -234,18 +376,21 @@ Conveyor& Conveyor::manage() {
 Conveyor& Conveyor::unmanage() {
 	Entity& en = Entity::get(id);
 
-	rebuild = true;
+	dissolve(belt);
 	managed = false;
+	en.changed(Save::Section::Conveyors);
 
 	if (prev) {
 		ensure(get(prev).next == id);
 		get(prev).next = 0;
+		Entity::get(prev).changed(Save::Section::Conveyors);
 		prev = 0;
 	}
 
 	if (next) {
 		ensure(get(next).prev == id);
 		get(next).prev = 0;
+		Entity::get(next).changed(Save::Section::Conveyors);
 		next = 0;
 	}
 
@@ -257,7 +402,9 @@ Conveyor& Conveyor::unmanage() {
 		if (eo.spec->conveyor) {
 			Conveyor& co = get(oid);
 			if (co.side == id) {
+				dissolve(co.belt);
 				co.side = 0;
+				eo.changed(Save::Section::Conveyors);
 			}
 		}
 	}
@@ -269,54 +416,53 @@ bool Conveyor::deliver(uint iiid) {
 	if (!iid) {
 		iid = iiid;
 		offset = steps-1;
+		wake(belt);
 		return true;
 	}
 	return false;
 }
 
-void Conveyor::update() {
-	for(;;) {
-		if (!iid) {
-			break;
-		}
-
-		uint nextOffset = cnext ? cnext->offset: 0;
+// Advance this segment's item one step. Returns true if anything changed.
+bool Conveyor::update() {
+	if (!iid) {
+		return false;
+	}
 
-		if (cnext && nextOffset && offset <= nextOffset) {
-			break;
-		}
+	uint nextOffset = cnext ? cnext->offset: 0;
 
-		if (!cnext && offset <= steps/2 && !cside) {
-			break;
-		}
+	if (cnext && nextOffset && offset <= nextOffset) {
+		return false;
+	}
 
-		if (offset > 0) {
-			offset--;
-			break;
-		}
+	if (!cnext && offset <= steps/2 && !cside) {
+		return false;
+	}
 
-		if (cnext && cnext->deliver(iid)) {
-			remove(iid);
-		}
+	if (offset > 0) {
+		offset--;
+		return true;
+	}
 
-		if (cside && cside->insert(iid)) {
-			remove(iid);
-		}
+	bool moved = false;
 
-		break;
+	if (cnext && cnext->deliver(iid)) {
+		remove(iid);
+		moved = true;
 	}
 
-	if (!cprev) {
-		return;
+	if (cside && cside->insert(iid)) {
+		remove(iid);
+		moved = true;
 	}
 
-	cprev->update();
+	return moved;
 }
 
 bool Conveyor::insert(uint iiid) {
 	if (!iid) {
 		iid = iiid;
 		offset = steps/2;
+		wake(belt);
 		return true;
 	}
 	return false;
@@ -326,6 +472,7 @@ bool Conveyor::remove(uint iiid) {
 	if (iid == iiid) {
 		iid = 0;
 		offset = 0;
+		wake(belt);
 		return true;
 	}
 	return false;
@@ -336,6 +483,7 @@ uint Conveyor::removeAny() {
 		uint iiid = iid;
 		iid = 0;
 		offset = 0;
+		wake(belt);
 		return iiid;
 	}
 	return 0;
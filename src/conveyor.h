@@ -8,10 +8,6 @@ struct Conveyor;
 #include "entity.h"
 #include "slabmap.h"
 
-// @todo improvements:
-// a) materialize conveyor belt lines to vectors for better interation locality
-// b) store relative offsets so only one gap per belt is decremented without iteration
-
 struct Conveyor {
 	uint id;
 	static void reset();
@@ -23,9 +19,41 @@ struct Conveyor {
 	static Conveyor& create(uint id);
 	static Conveyor& get(uint id);
 
+	// A belt is a line of linked conveyors materialized leader-first, walking
+	// upstream, so a tick iterates a flat array instead of recursing through
+	// cprev. A belt that makes no progress sleeps until an item is added or
+	// removed on it, or on a belt it sideloads onto.
+	struct Belt {
+		std::vector<Conveyor*> segments;
+		std::vector<uint> feeders;
+		gridwalk::xy chunk = {0,0};
+		bool contained = false;
+		bool circular = false;
+		bool awake = true;
+		// items moved since the last save; marking each segment as they
+		// move would cost a lookup per segment per tick
+		bool unsaved = false;
+	};
+
+	// Belts are keyed by leader id. Placing or removing a conveyor dissolves
+	// only the belts it touches; their segments become orphans that tick()
+	// reassembles, so edit cost follows belt size rather than world size.
+	// A full rebuild is only needed after loading.
 	static inline bool rebuild = true;
-	static inline std::vector<uint> leadersStraight;
-	static inline std::vector<uint> leadersCircular;
+	static inline std::map<uint,Belt> belts;
+	static inline std::set<uint> orphans;
+	static void wake(Belt* belt);
+	static void dissolve(Belt* belt);
+	static void assemble(uint id);
+	static void advance(Belt& belt);
+	static void changed(Belt* belt);
+
+	// Sim::regions: belts bucketed per Chunk tick in parallel, then
+	// belts crossing chunk edges tick serially
+	static inline bool regroup = true;
+	static inline std::vector<std::vector<Belt*>> regions;
+	static inline std::vector<Belt*> boundary;
+	static void group();
 
 	uint iid;
 	uint offset;
@@ -36,14 +64,14 @@ struct Conveyor {
 	Conveyor* cnext;
 	Conveyor* cprev;
 	Conveyor* cside;
-	bool marked;
 	bool managed;
+	Belt* belt;
 
 	void destroy();
 	Conveyor& manage();
 	Conveyor& unmanage();
 
-	void update();
+	bool update();
 	bool deliver(uint iid);
 
 	bool insert(uint iid);
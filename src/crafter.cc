@@ -1,14 +1,25 @@
 #include "common.h"
 #include "crafter.h"
 #include "ledger.h"
+#include "jobs.h"
 
 void Crafter::reset() {
 	all.clear();
 }
 
 void Crafter::tick() {
+	static std::vector<Crafter*> crafters;
+	crafters.clear();
 	for (auto& crafter: all) {
-		crafter.update();
+		crafters.push_back(&crafter);
+	}
+
+	Jobs::parallel(crafters.size(), 256, [&](uint begin, uint end) {
+		for (uint i = begin; i < end; i++) crafters[i]->animate();
+	});
+
+	for (auto crafter: crafters) {
+		crafter->update();
 	}
 }
 
@@ -238,9 +249,13 @@ void Crafter::retool(Recipe* r) {
 	energyUsed = 0;
 	progress = 0.0f;
 	efficiency = 0.0f;
+
+	en.changed(Save::Section::Crafters).changed(Save::Section::Stores);
 }
 
-void Crafter::update() {
+// Parallel phase: advance the animation state from last tick's progress.
+// The rest of update() stays serial; see Sim::update.
+void Crafter::animate() {
 	Entity& en = Entity::get(id);
 	if (en.isGhost()) return;
 
@@ -252,6 +267,11 @@ void Crafter::update() {
 			if (en.state >= en.spec->states.size()) en.state = 0;
 		}
 	}
+}
+
+void Crafter::update() {
+	Entity& en = Entity::get(id);
+	if (en.isGhost()) return;
 
 	if (exporting()) {
 
@@ -323,6 +343,7 @@ void Crafter::update() {
 	}
 
 	if (en.isEnabled() && working) {
+		en.changed(Save::Section::Crafters);
 		Energy energy = std::max(en.spec->crafterEnergyConsume, en.spec->energyConsume);
 		energyUsed += en.consume(energy * recipe->rate(en.spec));
 		efficiency = energyUsed.portion(energy);
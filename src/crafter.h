@@ -35,6 +35,7 @@ struct Crafter {
 	bool once;
 
 	void destroy();
+	void animate();
 	void update();
 
 	void craft(Recipe* recipe);
@@ -4,11 +4,22 @@
 
 void Depot::reset() {
 	all.clear();
+	schedule.clear();
 }
 
 void Depot::tick() {
-	for (auto& depot: all) {
+	for (uint id: schedule.ready(Sim::tick)) {
+		if (!all.has(id)) continue;
+		Depot& depot = get(id);
 		depot.update();
+
+		Entity& en = Entity::get(id);
+		if (en.isGhost() || depot.drones.size() >= en.spec->drones) {
+			schedule.sleep(id);
+		} else
+		if (depot.pause > Sim::tick) {
+			schedule.sleep(id, depot.pause);
+		}
 	}
 }
 
@@ -16,6 +27,7 @@ Depot& Depot::create(uint id) {
 	Depot& depot = all[id];
 	depot.id = id;
 	depot.pause = 0;
+	schedule.insert(id);
 	return depot;
 }
 
@@ -24,6 +36,7 @@ Depot& Depot::get(uint id) {
 }
 
 void Depot::destroy() {
+	schedule.remove(id);
 	all.erase(id);
 }
 
@@ -32,9 +45,11 @@ void Depot::update() {
 	if (en.isGhost()) return;
 	if (pause > Sim::tick) return;
 	if (drones.size() >= en.spec->drones) return;
+	en.changed(Save::Section::Depots);
 
 	Box range = en.pos.box().grow(32);
-	auto entities = Entity::intersecting(range);
+	static thread_local std::vector<uint> entities;
+	Entity::intersecting(range, entities);
 
 	for (uint eid: entities) {
 		Entity& se = Entity::get(eid);
@@ -106,11 +121,13 @@ void Depot::dispatch(uint dep, uint src, uint dst, Stack stack) {
 	Store& ss = drone.srcGhost ? se.ghost().store: se.store();
 	ss.reserve(stack);
 	ss.drones.insert(ed.id);
+	ss.changed();
 
 	Entity &de = Entity::get(dst);
 	Store& ds = drone.dstGhost ? de.ghost().store: de.store();
 	ds.promise(stack);
 	ds.drones.insert(ed.id);
+	ds.changed();
 
 	pause = Sim::tick + 30;
 }
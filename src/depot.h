@@ -8,6 +8,7 @@
 struct Depot;
 
 #include "slabmap.h"
+#include "wake-queue.h"
 #include "miniset.h"
 #include "entity.h"
 
@@ -19,6 +20,7 @@ struct Depot {
 	static void loadAll(const char* name);
 
 	static inline slabmap<Depot,&Depot::id> all;
+	static inline WakeQueue schedule;
 	static Depot& create(uint id);
 	static Depot& get(uint id);
 
@@ -0,0 +1,172 @@
+// Determinism test. Runs the same save for a number of ticks twice, once with
+// Jobs disabled (serial reference) in a child process and once with workers in
+// the parent, hashing simulation state after every tick. Exits non-zero and
+// reports the first tick where the runs diverge.
+//
+// With --regions both runs use region mode, so region bucketing is checked
+// against its own serial order.
+//
+//   ./factropy-determinism [--ticks N] [--threads N] [--regions] [save]
+
+#include "common.h"
+#include "mod.h"
+#include "sim.h"
+#include "entity.h"
+#include "scenario.h"
+#include "jobs.h"
+#include "path.h"
+#include <vector>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+	h ^= v + 0x9E3779B97F4A7C15ull + (h<<6) + (h>>2);
+	return h;
+}
+
+static uint64_t bits(float f) {
+	uint32_t u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+// Order-independent hash of the state parallel phases touch
+static uint64_t digest() {
+	uint64_t sum = 0;
+
+	for (auto& en: Entity::all) {
+		uint64_t h = en.id;
+		h = mix(h, Entity::dense.flags[en.slot]);
+		h = mix(h, bits(en.pos.x));
+		h = mix(h, bits(en.pos.y));
+		h = mix(h, bits(en.pos.z));
+		h = mix(h, bits(en.dir.x));
+		h = mix(h, bits(en.dir.z));
+		h = mix(h, en.state);
+		h = mix(h, en.health);
+		sum += h;
+	}
+
+	for (auto& conveyor: Conveyor::all) {
+		sum += mix(mix(conveyor.id, conveyor.iid), conveyor.offset);
+	}
+
+	for (auto& crafter: Crafter::all) {
+		sum += mix(mix(crafter.id, bits(crafter.progress)), crafter.completed);
+	}
+
+	for (auto& explosion: Explosion::all) {
+		sum += mix(explosion.id, bits(explosion.radius));
+	}
+
+	return mix(sum, Sim::tick);
+}
+
+static std::vector<uint64_t> run(const std::string& save, uint64_t ticks) {
+	Mod* mod = new ModDuktape("base");
+	mod->load();
+
+	scenario();
+
+	// a wall-clock budget would finish routes on load-dependent ticks
+	Path::budget = 0;
+
+	Sim::load(save.c_str());
+
+	std::vector<uint64_t> hashes;
+	for (uint64_t i = 0; i < ticks; i++) {
+		Sim::update();
+		mod->update();
+		hashes.push_back(digest());
+	}
+
+	delete mod;
+	return hashes;
+}
+
+int main(int argc, char const *argv[]) {
+	std::string save = "autosave";
+	uint64_t ticks = 600;
+	uint threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (int i = 1; i < argc; i++) {
+		auto arg = std::string(argv[i]);
+
+		if (arg == "--ticks" && i+1 < argc) {
+			ticks = std::max(1, std::atoi(argv[++i]));
+			continue;
+		}
+
+		if (arg == "--regions") {
+			Sim::regions = true;
+			continue;
+		}
+
+		if (arg == "--threads" && i+1 < argc) {
+			threads = std::max(1, std::atoi(argv[++i]));
+			continue;
+		}
+
+		if (arg.size() && arg[0] != '-') {
+			save = arg;
+			continue;
+		}
+
+		fatalf("unexpected argument: %s", arg.c_str());
+	}
+
+	if (!std::filesystem::exists(save)) {
+		fatalf("save not found: %s", save.c_str());
+	}
+
+	rlHeadless = true;
+
+	// serial reference in a child, so both runs start from a fresh process
+	int fds[2];
+	ensure(pipe(fds) == 0);
+
+	pid_t child = fork();
+	ensure(child >= 0);
+
+	if (!child) {
+		close(fds[0]);
+		Jobs::enabled = false;
+		auto hashes = run(save, ticks);
+		ensure(write(fds[1], hashes.data(), hashes.size()*sizeof(uint64_t)) == (ssize_t)(hashes.size()*sizeof(uint64_t)));
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	std::vector<uint64_t> serial(ticks);
+	size_t want = ticks*sizeof(uint64_t);
+	size_t got = 0;
+	while (got < want) {
+		ssize_t n = read(fds[0], (char*)serial.data()+got, want-got);
+		if (n <= 0) break;
+		got += n;
+	}
+	close(fds[0]);
+
+	int status = 0;
+	waitpid(child, &status, 0);
+	if (got != want || !WIFEXITED(status) || WEXITSTATUS(status)) {
+		fatalf("serial run failed");
+	}
+
+	Jobs::start(threads);
+	auto parallel = run(save, ticks);
+	Jobs::stop();
+
+	for (uint64_t i = 0; i < ticks; i++) {
+		if (serial[i] != parallel[i]) {
+			notef("FAIL: diverged at tick %lu of %lu (%u workers)", i+1, ticks, threads);
+			return 1;
+		}
+	}
+
+	notef("OK: %lu ticks identical (%u workers)", ticks, threads);
+	return 0;
+}
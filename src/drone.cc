@@ -31,7 +31,10 @@ Drone& Drone::get(uint id) {
 
 void Drone::destroy() {
 	if (dep && Entity::exists(dep)) {
-		Entity::get(dep).depot().drones.erase(id);
+		Entity& de = Entity::get(dep);
+		de.depot().drones.erase(id);
+		de.changed(Save::Section::Depots);
+		Depot::schedule.wake(dep);
 	}
 	all.erase(id);
 }
@@ -66,7 +69,10 @@ bool Drone::travel(uint eid) {
 	}
 
 	std::function<bool(Point, Point)> rayCast = [&](Point start, Point end) {
-		auto hits = Entity::intersecting(Box(start, end));
+		float step = 0.5f;
+
+		// skip the spatial query when nothing is indexed along the way
+		auto hits = Chunk::vacantLine(start, end, step) ? std::vector<uint>(): Entity::intersecting(Box(start, end));
 
 		discard_if(hits, [&](uint cid) {
 			return cid == id || cid == src || cid == dst || cid == dep || all.has(cid);
@@ -77,7 +83,6 @@ bool Drone::travel(uint eid) {
 			boxes.push_back(Entity::get(cid).box());
 		}
 
-		float step = 0.5f;
 		Point direction = (end - start).normalize();
 		int steps = (int)std::floor(start.distance(end) / step);
 
@@ -124,6 +129,7 @@ bool Drone::travel(uint eid) {
 void Drone::update() {
 	Entity& en = Entity::get(id);
 	if (en.isGhost()) return;
+	en.changed(Save::Section::Drones);
 
 	switch (stage) {
 		case ToSrc: {
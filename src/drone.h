@@ -26,9 +26,9 @@ struct Drone {
 	};
 
 	uint iid;
-	uint dep;
-	uint src;
-	uint dst;
+	slabhandle<uint> dep;
+	slabhandle<uint> src;
+	slabhandle<uint> dst;
 	Stack stack;
 	bool srcGhost;
 	bool dstGhost;
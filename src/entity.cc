@@ -13,6 +13,8 @@ void Entity::reset() {
 	}
 	all.clear();
 	grid.clear();
+	dense.clear();
+	PathGraph::reset();
 	Store::reset();
 	Pipe::reset();
 }
@@ -75,6 +77,7 @@ uint Entity::next() {
 	for (uint i = 0; i < MaxEntity; i++) {
 		if (sequence == MaxEntity) {
 			sequence = 0;
+			laps++;
 		}
 		sequence++;
 		if (!all.has(sequence)) {
@@ -87,12 +90,13 @@ uint Entity::next() {
 Entity& Entity::create(uint id, Spec *spec) {
 	Entity& en = all[id];
 	en.id = id;
+	en.slot = dense.claim(id);
 	en.spec = spec;
 	en.dir = Point::South;
 	en.state = 0;
 	en.health = spec->health;
 
-	en.flags = GHOST | ENABLED;
+	dense.flags[en.slot] = GHOST | ENABLED;
 	Ghost::create(id, Entity::next());
 
 	if (spec->store) {
@@ -184,16 +188,21 @@ Entity& Entity::create(uint id, Spec *spec) {
 		names[id] = fmt("%s %u", spec->name, id);
 	}
 
+	// not indexed until the caller moves it into place
 	en.pos = {0,0,0};
-	en.move((Point){0,0,0});
 
 	return en;
 }
 
 void Entity::destroy() {
+	wake();
 	unmanage();
 	unindex();
 
+	if (dense.placed[slot] && !PathGraph::mobile(spec)) {
+		PathGraph::invalidate(dense.bounds[slot]);
+	}
+
 	if (isGhost()) {
 		ghost().destroy();
 	}
@@ -283,6 +292,8 @@ void Entity::destroy() {
 	}
 
 	names.erase(id);
+	dense.release(slot);
+	Save::destroyed(id);
 	all.erase(id);
 }
 
@@ -294,12 +305,68 @@ Entity& Entity::get(uint id) {
 	return all.refer(id);
 }
 
+bool Entity::exists(slabhandle<uint>& id) {
+	return id.key > 0 && all.has(id);
+}
+
+Entity& Entity::get(slabhandle<uint>& id) {
+	return all.refer(id);
+}
+
+uint Entity::Dense::claim(uint id) {
+	uint slot;
+	if (free.size()) {
+		slot = free.back();
+		free.pop_back();
+	} else {
+		slot = ids.size();
+		ids.push_back(0);
+		flags.push_back(0);
+		bounds.push_back(Box());
+		indexed.push_back(false);
+		placed.push_back(false);
+		dirty.push_back(0);
+	}
+	ids[slot] = id;
+	flags[slot] = 0;
+	bounds[slot] = Box();
+	indexed[slot] = false;
+	placed[slot] = false;
+	dirty[slot] = ~0u;
+	return slot;
+}
+
+void Entity::Dense::release(uint slot) {
+	ids[slot] = 0;
+	flags[slot] = 0;
+	dirty[slot] = 0;
+	free.push_back(slot);
+}
+
+void Entity::Dense::clear() {
+	ids.clear();
+	flags.clear();
+	bounds.clear();
+	indexed.clear();
+	placed.clear();
+	dirty.clear();
+	free.clear();
+}
+
+void Entity::Dense::toIds(std::vector<uint>& slots) {
+	for (auto& slot: slots) slot = ids[slot];
+	std::sort(slots.begin(), slots.end());
+}
+
 bool Entity::fits(Spec *spec, Point pos, Point dir) {
 	Box bounds = spec->box(pos, dir, spec->collision).shrink(0.1);
 
-	for (auto cid: intersecting(bounds)) {
-		if (get(cid).spec->collideBuild) return false;
-	}
+	bool clear = true;
+	forEachIntersecting(bounds, [&](uint cid) {
+		clear = !get(cid).spec->collideBuild;
+		return clear;
+	});
+	if (!clear) return false;
 
 	if (spec->place != Spec::Footings) {
 		for (auto [x,y]: Chunk::walkTiles(bounds)) {
@@ -330,26 +397,55 @@ bool Entity::fits(Spec *spec, Point pos, Point dir) {
 }
 
 std::vector<uint> Entity::intersecting(Box box) {
-	auto hits = grid.search(box);
-	discard_if(hits, [&](uint id) { return !get(id).box().intersects(box); });
+	std::vector<uint> hits;
+	intersecting(box, hits);
 	return hits;
 }
 
 std::vector<uint> Entity::intersecting(Sphere sphere) {
-	auto hits = grid.search(sphere);
-	discard_if(hits, [&](uint id) { return !get(id).sphere().intersects(sphere); });
+	std::vector<uint> hits;
+	intersecting(sphere, hits);
 	return hits;
 }
 
 std::vector<uint> Entity::intersecting(Point pos, float radius) {
-	auto hits = intersecting(pos.box().grow(radius));
-	discard_if(hits, [&](uint id) { return !(get(id).pos.distance(pos) < radius); });
+	std::vector<uint> hits;
+	intersecting(pos, radius, hits);
 	return hits;
 }
 
+// The grid holds dense slots, so the bounds test reads Dense::bounds and
+// only survivors are mapped back to ids.
+
+void Entity::intersecting(Box box, std::vector<uint>& hits) {
+	grid.search(box, hits);
+	discard_if(hits, [&](uint slot) { return !dense.bounds[slot].intersects(box); });
+	dense.toIds(hits);
+}
+
+void Entity::intersecting(Sphere sphere, std::vector<uint>& hits) {
+	grid.search(sphere, hits);
+	discard_if(hits, [&](uint slot) { return !dense.bounds[slot].sphere().intersects(sphere); });
+	dense.toIds(hits);
+}
+
+void Entity::intersecting(Point pos, float radius, std::vector<uint>& hits) {
+	intersecting(pos.box().grow(radius), hits);
+	discard_if(hits, [&](uint id) { return !(get(id).pos.distance(pos) < radius); });
+}
+
+// Lowest intersecting id, matching the front of the sorted intersecting()
+// result so callers stay deterministic regardless of grid cell order.
+uint Entity::firstIntersecting(Box box) {
+	uint first = 0;
+	forEachIntersecting(box, [&](uint id) {
+		if (!first || id < first) first = id;
+	});
+	return first;
+}
+
 uint Entity::at(Point p) {
-	auto hits = intersecting(p.box());
-	return hits.size() ? hits.front(): 0;
+	return firstIntersecting(p.box());
 }
 
 std::vector<uint> Entity::enemiesInRange(Point pos, float radius) {
@@ -374,57 +470,86 @@ void Entity::explode() {
 }
 
 void Entity::removeJunk(Box b) {
-	for (uint eid: intersecting(b)) {
+	forEachIntersecting(b, [&](uint eid) {
 		Entity& ke = Entity::get(eid);
 		if (ke.spec->junk) {
 			ke.remove();
 		}
-	}
+	});
 }
 
 bool Entity::isGhost() {
-	return (flags & GHOST) != 0;
+	return (dense.flags[slot] & GHOST) != 0;
 }
 
 Entity& Entity::setGhost(bool state) {
+	uint32_t& flags = dense.flags[slot];
+	uint32_t old = flags;
 	flags = state ? (flags | GHOST) : (flags & ~GHOST);
+	if (flags != old) wake().changed(Save::Section::Entities);
 	return *this;
 }
 
 bool Entity::isConstruction() {
-	return (flags & CONSTRUCTION) != 0;
+	return (dense.flags[slot] & CONSTRUCTION) != 0;
 }
 
 Entity& Entity::setConstruction(bool state) {
+	uint32_t& flags = dense.flags[slot];
 	flags = state ? (flags | CONSTRUCTION) : (flags & ~CONSTRUCTION);
-	return *this;
+	return changed(Save::Section::Entities);
 }
 
 bool Entity::isDeconstruction() {
-	return (flags & DECONSTRUCTION) != 0;
+	return (dense.flags[slot] & DECONSTRUCTION) != 0;
 }
 
 Entity& Entity::setDeconstruction(bool state) {
+	uint32_t& flags = dense.flags[slot];
 	flags = state ? (flags | DECONSTRUCTION) : (flags & ~DECONSTRUCTION);
-	return *this;
+	return changed(Save::Section::Entities);
 }
 
 bool Entity::isEnabled() {
-	return (flags & ENABLED) != 0;
+	return (dense.flags[slot] & ENABLED) != 0;
 }
 
 Entity& Entity::setEnabled(bool state) {
+	uint32_t& flags = dense.flags[slot];
+	uint32_t old = flags;
 	flags = state ? (flags | ENABLED) : (flags & ~ENABLED);
+	if (flags != old) wake().changed(Save::Section::Entities);
+	return *this;
+}
+
+// Rouse any components sleeping on this entity's state, and any watching it
+Entity& Entity::wake() {
+	Arm::schedule.wake(id);
+	Depot::schedule.wake(id);
+	Loader::schedule.wake(id);
+	return *this;
+}
+
+// Mark state for the next journaled save. Only from serial phases, or for
+// an entity the calling job owns.
+Entity& Entity::changed(Save::Section section) {
+	dense.dirty[slot] |= Save::bit(section);
+	return *this;
+}
+
+Entity& Entity::changed() {
+	dense.dirty[slot] = ~0u;
 	return *this;
 }
 
 bool Entity::isGenerating() {
-	return (flags & GENERATING) != 0;
+	return (dense.flags[slot] & GENERATING) != 0;
 }
 
 Entity& Entity::setGenerating(bool state) {
+	uint32_t& flags = dense.flags[slot];
 	flags = state ? (flags | GENERATING) : (flags & ~GENERATING);
-	return *this;
+	return changed(Save::Section::Entities);
 }
 
 std::string Entity::name() {
@@ -434,6 +559,7 @@ std::string Entity::name() {
 bool Entity::rename(std::string name) {
 	if (spec->named) {
 		names[id] = name;
+		changed(Save::Section::Entities);
 		return true;
 	}
 	return false;
@@ -451,11 +577,13 @@ Box Entity::miningBox() {
 	return box().grow(0.5f);
 }
 
+// Turning something not yet moved into place leaves it unindexed.
 Entity& Entity::look(Point p) {
+	bool indexed = dense.indexed[slot];
 	unmanage();
 	unindex();
 	dir = p.normalize();
-	index();
+	if (indexed) index();
 	manage();
 	return *this;
 }
@@ -472,12 +600,35 @@ bool Entity::lookAtPivot(Point o) {
 }
 
 Entity& Entity::index() {
-	grid.insert(box(), id);
+	if (dense.indexed[slot]) unindex();
+
+	bool had = dense.placed[slot];
+	Box was = dense.bounds[slot];
+	dense.bounds[slot] = box();
+	dense.indexed[slot] = true;
+	dense.placed[slot] = true;
+	grid.insert(dense.bounds[slot], slot);
+	Chunk::occupy(dense.bounds[slot]);
+	// pos and dir only change between unindex() and index()
+	changed(Save::Section::Entities);
+
+	// turning on the spot is common and changes nothing for path-finding
+	Box now = dense.bounds[slot];
+	bool same = was.x == now.x && was.z == now.z && was.w == now.w && was.d == now.d;
+	if (!same && !PathGraph::mobile(spec)) {
+		if (had) PathGraph::invalidate(was);
+		PathGraph::invalidate(now);
+	}
 	return *this;
 }
 
+// Removes using the bounds recorded by index(), so it doesn't matter if
+// pos or dir already changed.
 Entity& Entity::unindex() {
-	grid.remove(box(), id);
+	if (!dense.indexed[slot]) return *this;
+	dense.indexed[slot] = false;
+	grid.remove(dense.bounds[slot], slot);
+	Chunk::vacate(dense.bounds[slot]);
 	return *this;
 }
 
@@ -673,6 +824,7 @@ void Entity::damage(Health hits) {
 	if (!spec->health) return;
 
 	health -= hits;
+	changed(Save::Section::Entities);
 	if (health < 0) {
 		unmanage();
 		if (spec->explodes) explode(); else remove();
@@ -27,6 +27,7 @@ struct GuiFakeEntity;
 #include "box.h"
 #include "sphere.h"
 #include "ghost.h"
+#include "save.h"
 
 // Components
 
@@ -51,7 +52,7 @@ struct GuiFakeEntity;
 
 struct Entity {
 	uint id;
-	uint32_t flags;
+	uint slot;
 	Spec* spec;
 	Point pos;
 	Point dir;
@@ -64,6 +65,27 @@ struct Entity {
 	static const uint32_t ENABLED = 1<<3;
 	static const uint32_t GENERATING = 1<<4;
 
+	// Hot per-entity state in dense arrays indexed by Entity::slot, apart from
+	// the rest of the record. Flag checks and bounding-box tests read these
+	// contiguously, and the grid stores slots rather than ids so a spatial
+	// query never touches an Entity it rejects. Slots are recycled but fixed
+	// for an entity's lifetime.
+	struct Dense {
+		std::vector<uint> ids; // 0 when free
+		std::vector<uint32_t> flags;
+		std::vector<Box> bounds; // as of the last index()
+		std::vector<bool> indexed; // in grid and Chunk rasters
+		std::vector<bool> placed; // indexed since claim(), so bounds are real
+		std::vector<uint32_t> dirty; // Save::bit()s changed since the last save
+		std::vector<uint> free;
+
+		uint claim(uint id);
+		void release(uint slot);
+		void clear();
+		void toIds(std::vector<uint>& slots);
+	};
+
+	static inline Dense dense;
 	static inline gridmap<32,uint> grid;
 	static inline std::set<uint> removing;
 	static inline std::set<uint> exploding;
@@ -79,6 +101,8 @@ struct Entity {
 
 	static inline slabmap<Entity,&Entity::id> all;
 	static inline uint sequence = 0;
+	// times sequence has wrapped at MaxEntity
+	static inline uint64_t laps = 0;
 	static uint next();
 
 	static inline std::map<uint,std::string> names;
@@ -86,6 +110,8 @@ struct Entity {
 	static Entity& create(uint id, Spec* spec);
 	static bool exists(uint id);
 	static Entity& get(uint id);
+	static bool exists(slabhandle<uint>& id);
+	static Entity& get(slabhandle<uint>& id);
 
 	static void saveAll(const char* name);
 	static void loadAll(const char* name);
@@ -97,8 +123,29 @@ struct Entity {
 	static std::vector<uint> intersecting(Box box);
 	static std::vector<uint> intersecting(Sphere sphere);
 	static std::vector<uint> intersecting(Point pos, float radius);
+	static void intersecting(Box box, std::vector<uint>& out);
+	static void intersecting(Sphere sphere, std::vector<uint>& out);
+	static void intersecting(Point pos, float radius, std::vector<uint>& out);
+	static uint firstIntersecting(Box box);
 	static uint at(Point p);
 
+	// Visit entities intersecting box without allocating. Order is arbitrary;
+	// use the buffer overloads where order matters. A callback returning bool
+	// stops the walk by returning false.
+	template <typename F>
+	static void forEachIntersecting(Box box, F fn) {
+		grid.each(box, [&](uint slot) {
+			if (!dense.bounds[slot].intersects(box)) return true;
+			uint id = dense.ids[slot];
+			if constexpr (std::is_same_v<decltype(fn(id)),bool>) {
+				return fn(id);
+			} else {
+				fn(id);
+				return true;
+			}
+		});
+	}
+
 	static std::vector<uint> enemiesInRange(Point pos, float radius);
 
 	bool isGhost();
@@ -109,6 +156,9 @@ struct Entity {
 	Entity& setDeconstruction(bool state);
 	bool isEnabled();
 	Entity& setEnabled(bool state);
+	Entity& wake();
+	Entity& changed(Save::Section section);
+	Entity& changed();
 	bool isGenerating();
 	Entity& setGenerating(bool state);
 
@@ -1,14 +1,28 @@
 #include "common.h"
 #include "entity.h"
 #include "explosion.h"
+#include "jobs.h"
 
 void Explosion::reset() {
 	all.clear();
 }
 
 void Explosion::tick() {
+	// transient and never pointed at between ticks, so safe to repack
+	if (all.sparse()) all.compact();
+
+	static std::vector<Explosion*> explosions;
+	explosions.clear();
 	for (auto& explosion: all) {
-		explosion.update();
+		explosions.push_back(&explosion);
+	}
+
+	Jobs::parallel(explosions.size(), 16, [&](uint begin, uint end) {
+		for (uint i = begin; i < end; i++) explosions[i]->plan();
+	});
+
+	for (auto explosion: explosions) {
+		explosion->update();
 	}
 }
 
@@ -19,6 +33,7 @@ Explosion& Explosion::create(uint id) {
 	explosion.range = 0;
 	explosion.rate = 0;
 	explosion.damage = 0;
+	explosion.detonating = false;
 	return explosion;
 }
 
@@ -30,23 +45,36 @@ void Explosion::destroy() {
 	all.erase(id);
 }
 
-void Explosion::update() {
+// Parallel phase: grow, or find what the blast hits
+void Explosion::plan() {
+	detonating = false;
+
 	Entity& en = Entity::get(id);
 	if (en.isGhost()) return;
 
 	if (radius >= range) {
-		for (auto tid: Entity::intersecting(en.pos, range)) {
-			if (tid == id) continue;
-			Entity& te = Entity::get(tid);
-			te.damage(damage);
-		}
-		en.remove();
+		Entity::intersecting(en.pos, range, targets);
+		detonating = true;
 		return;
 	}
 
 	radius += rate;
 }
 
+// Serial phase: apply damage
+void Explosion::update() {
+	if (!detonating) return;
+	detonating = false;
+
+	Entity& en = Entity::get(id);
+	for (auto tid: targets) {
+		if (tid == id) continue;
+		Entity& te = Entity::get(tid);
+		te.damage(damage);
+	}
+	en.remove();
+}
+
 void Explosion::define(Health ddamage, float rradius, float rrate) {
 	damage = ddamage;
 	radius = 0.0;
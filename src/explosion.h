@@ -20,7 +20,12 @@ struct Explosion {
 	float range;
 	float rate;
 
+	// per-tick plan, see Sim::update
+	bool detonating;
+	std::vector<uint> targets;
+
 	void destroy();
+	void plan();
 	void update();
 
 	void define(Health damage, float radius, float rate);
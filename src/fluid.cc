@@ -34,13 +34,15 @@ Fluid::~Fluid() {
 }
 
 Fluid* Fluid::byName(std::string name) {
-	ensuref(names.count(name) == 1, "unknown fluid %s", name.c_str());
-	return names[name];
+	auto it = names.find(name);
+	ensuref(it != names.end(), "unknown fluid %s", name.c_str());
+	return it->second;
 }
 
 Fluid* Fluid::get(uint id) {
-	ensuref(ids.count(id) == 1, "unknown fluid %d", id);
-	return ids[id];
+	auto it = ids.find(id);
+	ensuref(it != ids.end(), "unknown fluid %d", id);
+	return it->second;
 }
 
 bool Fluid::manufacturable() {
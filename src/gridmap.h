@@ -4,49 +4,211 @@
 // up into chunks/tiles of a predefined size. It can store anything that
 // has an axis-aligned bounding box.
 
+// Cells live in an open-addressed hash table (linear probing, backward-shift
+// deletion, so no tombstones) keyed on tile coordinates. Each cell holds a
+// few values inline and only spills to the heap when crowded, so a typical
+// lookup touches one or two adjacent slots and no pointers.
+
 #include "common.h"
 #include "gridwalk.h"
-#include <map>
+#include <vector>
 
-template <auto CHUNK, typename V>
+template <auto CHUNK, typename V, uint INLINE = 6>
 struct gridmap {
 
-	std::map<gridwalk::xy,std::vector<V>> cells;
+	struct cell {
+		gridwalk::xy xy = {0,0};
+		bool used = false;
+		uint count = 0;
+		V local[INLINE];
+		std::vector<V> spill;
+
+		V& at(uint i) {
+			return i < INLINE ? local[i]: spill[i-INLINE];
+		}
+
+		void push(V id) {
+			if (count < INLINE) {
+				local[count] = id;
+			} else {
+				spill.push_back(id);
+			}
+			count++;
+		}
+
+		void drop(V id) {
+			for (uint i = 0; i < count; i++) {
+				if (at(i) == id) {
+					at(i) = at(count-1);
+					if (count > INLINE) spill.pop_back();
+					count--;
+					return;
+				}
+			}
+		}
+
+		bool has(V id) {
+			for (uint i = 0; i < count; i++) {
+				if (at(i) == id) return true;
+			}
+			return false;
+		}
+
+		template <typename F>
+		void each(F fn) {
+			uint n = std::min(count, INLINE);
+			for (uint i = 0; i < n; i++) fn(local[i]);
+			for (auto id: spill) fn(id);
+		}
+	};
+
+	std::vector<cell> cells;
+	uint used = 0;
 
 	gridmap() {};
 
+	static std::size_t hash(const gridwalk::xy& xy) {
+		uint64_t h = (uint64_t)(uint32_t)xy.x * 0x9E3779B97F4A7C15ull;
+		h ^= (uint64_t)(uint32_t)xy.y + 0x7F4A7C159E3779B9ull + (h<<6) + (h>>2);
+		return (std::size_t)(h ^ (h>>29));
+	}
+
+	std::size_t mask() const {
+		return cells.size()-1;
+	}
+
+	cell* find(const gridwalk::xy& xy) {
+		if (!used) return nullptr;
+		for (std::size_t i = hash(xy) & mask(); cells[i].used; i = (i+1) & mask()) {
+			if (cells[i].xy == xy) return &cells[i];
+		}
+		return nullptr;
+	}
+
+	void grow() {
+		std::vector<cell> old;
+		old.swap(cells);
+		cells.resize(std::max((std::size_t)64, old.size()*2));
+		for (auto& c: old) {
+			if (!c.used) continue;
+			std::size_t i = hash(c.xy) & mask();
+			while (cells[i].used) i = (i+1) & mask();
+			cells[i] = std::move(c);
+		}
+	}
+
+	cell& obtain(const gridwalk::xy& xy) {
+		// keep load <= 50% so probe runs stay short
+		if ((used+1)*2 > cells.size()) grow();
+
+		std::size_t i = hash(xy) & mask();
+		for (; cells[i].used; i = (i+1) & mask()) {
+			if (cells[i].xy == xy) return cells[i];
+		}
+
+		used++;
+		cells[i].used = true;
+		cells[i].xy = xy;
+		cells[i].count = 0;
+		return cells[i];
+	}
+
+	void release(cell* c) {
+		std::size_t i = c - cells.data();
+		cells[i] = cell();
+		used--;
+
+		// backward-shift any following entries that probed past the hole
+		for (std::size_t j = (i+1) & mask(); cells[j].used; j = (j+1) & mask()) {
+			std::size_t home = hash(cells[j].xy) & mask();
+			bool movable = (j > i) ? (home <= i || home > j): (home <= i && home > j);
+			if (movable) {
+				cells[i] = std::move(cells[j]);
+				cells[j] = cell();
+				i = j;
+			}
+		}
+	}
+
 	void insert(Box box, V id) {
-		for (auto cell: gridwalk(CHUNK, box)) {
-			cells[cell].push_back(id);
+		for (auto xy: gridwalk(CHUNK, box)) {
+			obtain(xy).push(id);
 		}
 	}
 
 	void remove(Box box, V id) {
-		for (auto cell: gridwalk(CHUNK, box)) {
-			auto& v = cells[cell];
-			v.erase(std::remove(v.begin(), v.end(), id), v.end());
-			if (!v.size()) cells.erase(cell);
+		for (auto xy: gridwalk(CHUNK, box)) {
+			cell* c = find(xy);
+			if (!c) continue;
+			c->drop(id);
+			if (!c->count) release(c);
 		}
 	}
 
 	void clear() {
 		cells.clear();
+		cells.shrink_to_fit();
+		used = 0;
+	}
+
+	// Fill a caller-owned buffer, reusing its capacity. Sorted, unique.
+	void search(Box box, std::vector<V>& hits) {
+		hits.clear();
+		for (auto xy: gridwalk(CHUNK, box)) {
+			cell* c = find(xy);
+			if (c) c->each([&](V id) { hits.push_back(id); });
+		}
+		deduplicate(hits);
 	}
 
 	std::vector<V> search(Box box) {
 		std::vector<V> hits;
-		for (auto cell: gridwalk(CHUNK, box)) {
-			if (cells.count(cell)) {
-				for (auto id: cells[cell]) {
-					hits.push_back(id);
-				}
+		search(box, hits);
+		return hits;
+	}
+
+	// Visit each value overlapping box once, in no particular order, stopping
+	// early if fn returns false. Small boxes spanning a few cells dedup by
+	// re-checking earlier cells and never allocate; larger areas fall back to
+	// search(). The gridmap must not be modified during the walk.
+	template <typename F>
+	bool each(Box box, F fn) {
+		gridwalk walk(CHUNK, box);
+		auto first = walk.begin();
+		auto last = walk.end();
+
+		if ((first.cx1-first.cx0)*(first.cy1-first.cy0) > 4) {
+			for (auto id: search(box)) {
+				if (!fn(id)) return false;
 			}
+			return true;
 		}
-		deduplicate(hits);
-		return hits;
+
+		auto seen = [&](gridwalk::iterator it, V id) {
+			for (auto pt = first; pt != it; ++pt) {
+				cell* c = find(*pt);
+				if (c && c->has(id)) return true;
+			}
+			return false;
+		};
+
+		for (auto it = first; it != last; ++it) {
+			cell* c = find(*it);
+			if (!c) continue;
+			for (uint i = 0; i < c->count; i++) {
+				V id = c->at(i);
+				if (seen(it, id)) continue;
+				if (!fn(id)) return false;
+			}
+		}
+		return true;
+	}
+
+	void search(Sphere sphere, std::vector<V>& hits) {
+		search((Box){sphere.x, sphere.y, sphere.z, sphere.r*2, sphere.r*2, sphere.r*2}, hits);
 	}
 
 	std::vector<V> search(Sphere sphere) {
 		return search((Box){sphere.x, sphere.y, sphere.z, sphere.r*2, sphere.r*2, sphere.r*2});
 	}
-};
\ No newline at end of file
+};
@@ -54,13 +54,15 @@ Item::~Item() {
 }
 
 Item* Item::byName(std::string name) {
-	ensuref(names.count(name) == 1, "unknown item %s", name.c_str());
-	return names[name];
+	auto it = names.find(name);
+	ensuref(it != names.end(), "unknown item %s", name.c_str());
+	return it->second;
 }
 
 Item* Item::get(uint id) {
-	ensuref(ids.count(id) == 1, "unknown item %d", id);
-	return ids[id];
+	auto it = ids.find(id);
+	ensuref(it != ids.end(), "unknown item %d", id);
+	return it->second;
 }
 
 bool Item::manufacturable() {
@@ -0,0 +1,145 @@
+#include "common.h"
+#include "jobs.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace Jobs {
+	std::atomic<bool> enabled = true;
+
+	namespace {
+		struct Job {
+			rangeCallback* fn;
+			uint begin;
+			uint end;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		// queue 0 belongs to the calling thread
+		std::vector<Queue*> queues;
+		std::vector<std::thread> threads;
+		std::atomic<uint> pending = 0;
+
+		std::mutex sleeping;
+		std::condition_variable wakeup;
+		uint64_t generation = 0;
+		bool stopping = false;
+
+		bool pop(uint self, Job& job) {
+			Queue* queue = queues[self];
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			if (queue->jobs.empty()) return false;
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			return true;
+		}
+
+		bool steal(uint self, Job& job) {
+			for (uint i = 1; i < queues.size(); i++) {
+				Queue* queue = queues[(self+i)%queues.size()];
+				std::lock_guard<std::mutex> lock(queue->mutex);
+				if (queue->jobs.empty()) continue;
+				job = queue->jobs.front();
+				queue->jobs.pop_front();
+				return true;
+			}
+			return false;
+		}
+
+		bool take(uint self, Job& job) {
+			return pop(self, job) || steal(self, job);
+		}
+
+		void execute(Job& job) {
+			(*job.fn)(job.begin, job.end);
+			pending--;
+		}
+
+		void worker(uint self) {
+			uint64_t seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(sleeping);
+					wakeup.wait(lock, [&]() { return stopping || generation != seen; });
+					if (stopping) return;
+					seen = generation;
+				}
+				Job job;
+				while (take(self, job)) {
+					execute(job);
+				}
+			}
+		}
+	}
+
+	void start(uint count) {
+		stop();
+		queues.push_back(new Queue);
+		for (uint i = 1; i <= count; i++) {
+			queues.push_back(new Queue);
+		}
+		for (uint i = 1; i <= count; i++) {
+			threads.push_back(std::thread(worker, i));
+		}
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(sleeping);
+			stopping = true;
+		}
+		wakeup.notify_all();
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		threads.clear();
+		for (auto queue: queues) {
+			delete queue;
+		}
+		queues.clear();
+		stopping = false;
+	}
+
+	uint workers() {
+		return threads.size();
+	}
+
+	void parallel(uint count, uint grain, rangeCallback fn) {
+		if (!count) return;
+		grain = std::max(grain, 1u);
+
+		if (!enabled || threads.empty() || count <= grain) {
+			fn(0, count);
+			return;
+		}
+
+		uint n = 0;
+		for (uint begin = 0; begin < count; begin += grain, n++) {
+			Queue* queue = queues[n%queues.size()];
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->jobs.push_back({&fn, begin, std::min(count, begin+grain)});
+			pending++;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sleeping);
+			generation++;
+		}
+		wakeup.notify_all();
+
+		Job job;
+		while (pending) {
+			if (take(0, job)) {
+				execute(job);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// A small work-stealing job system for data-parallel simulation phases.
+// parallel(n, grain, fn) splits [0,n) into grain-sized jobs dealt across one
+// deque per thread; each thread pops from the back of its own deque and
+// steals from the front of the others when it runs dry. The calling thread
+// helps out, and parallel() returns only once every job has run.
+//
+// With no workers started, or with enabled = false, fn(0,n) just runs inline
+// on the caller. That is the serial reference behaviour determinism is
+// measured against. parallel() is not re-entrant: jobs must not call it.
+
+#include <atomic>
+#include <functional>
+
+namespace Jobs {
+	extern std::atomic<bool> enabled;
+
+	void start(uint threads);
+	void stop();
+	uint workers();
+
+	typedef std::function<void(uint,uint)> rangeCallback;
+	void parallel(uint count, uint grain, rangeCallback fn);
+}
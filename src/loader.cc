@@ -4,11 +4,22 @@
 
 void Loader::reset() {
 	all.clear();
+	schedule.clear();
 }
 
 void Loader::tick() {
-	for (auto& loader: all) {
+	for (uint id: schedule.ready(Sim::tick)) {
+		if (!all.has(id)) continue;
+		Loader& loader = get(id);
 		loader.update();
+
+		Entity& en = Entity::get(id);
+		if (en.isGhost() || !en.isEnabled()) {
+			schedule.sleep(id);
+		} else
+		if (loader.pause > Sim::tick) {
+			schedule.sleep(id, loader.pause);
+		}
 	}
 }
 
@@ -18,6 +29,7 @@ Loader& Loader::create(uint id) {
 	loader.id = id;
 	loader.pause = 0;
 	loader.loading = !en.spec->loaderUnload;
+	schedule.insert(id);
 	return loader;
 }
 
@@ -26,6 +38,7 @@ Loader& Loader::get(uint id) {
 }
 
 void Loader::destroy() {
+	schedule.remove(id);
 	all.erase(id);
 }
 
@@ -100,6 +113,7 @@ void Loader::update() {
 	if (en.isGhost()) return;
 	if (!en.isEnabled()) return;
 	if (pause > Sim::tick) return;
+	en.changed(Save::Section::Loaders);
 
 	auto& conveyor = Conveyor::get(id);
 
@@ -142,6 +156,8 @@ void Loader::update() {
 		Stack stack = transferBeltToStore(store, {conveyor.iid,1});
 		if (stack.iid == conveyor.iid && stack.size && store.insert({stack.iid,1}).size == 0) {
 			conveyor.remove(stack.iid);
+		} else {
+			idle();
 		}
 		return;
 	}
@@ -150,7 +166,17 @@ void Loader::update() {
 		Stack stack = transferStoreToBelt(store);
 		if (stack.iid && stack.size && conveyor.deliver(stack.iid)) {
 			store.remove(stack);
+		} else
+		if (!stack.iid || !stack.size) {
+			idle();
 		}
 		return;
 	}
 }
+
+// The store can't take or give anything until it changes; sleep until
+// Store::changed() wakes us, with a slow poll for filter edits.
+void Loader::idle() {
+	schedule.watch(id, storeId);
+	schedule.sleep(id, Sim::tick+60);
+}
@@ -9,6 +9,7 @@ struct Loader;
 #include "entity.h"
 #include "conveyor.h"
 #include "slabmap.h"
+#include "wake-queue.h"
 
 struct Loader {
 	uint id;
@@ -18,6 +19,7 @@ struct Loader {
 	static void loadAll(const char* name);
 
 	static inline slabmap<Loader,&Loader::id> all;
+	static inline WakeQueue schedule;
 	static Loader& create(uint id);
 	static Loader& get(uint id);
 
@@ -28,6 +30,7 @@ struct Loader {
 
 	void destroy();
 	void update();
+	void idle();
 
 	Point point();
 
@@ -0,0 +1,132 @@
+#include "common.h"
+#include "lz.h"
+#include <cstdint>
+#include <vector>
+
+namespace LZ {
+	static const uint MinMatch = 4;
+	static const uint MaxOffset = 65535;
+	static const uint HashBits = 12;
+
+	static uint32_t read32(const char* p) {
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static uint hash(uint32_t v) {
+		return (v * 2654435761u) >> (32-HashBits);
+	}
+
+	static void length(std::string& out, size_t n) {
+		for (; n >= 255; n -= 255) out.push_back((char)255);
+		out.push_back((char)n);
+	}
+
+	static void sequence(std::string& out, const char* literals, size_t count, size_t offset, size_t match) {
+		uint8_t token = (uint8_t)(std::min(count, (size_t)15) << 4);
+		if (match) token |= (uint8_t)std::min(match-MinMatch, (size_t)15);
+		out.push_back((char)token);
+
+		if (count >= 15) length(out, count-15);
+		out.append(literals, count);
+
+		if (match) {
+			out.push_back((char)(offset & 0xff));
+			out.push_back((char)(offset >> 8));
+			if (match-MinMatch >= 15) length(out, match-MinMatch-15);
+		}
+	}
+
+	std::string compress(const std::string& in) {
+		std::string out;
+		out.reserve(in.size()/2 + 16);
+
+		const char* src = in.data();
+		size_t size = in.size();
+
+		// last position+1 seen for each hash of four bytes
+		std::vector<uint32_t> table(1<<HashBits, 0);
+
+		size_t anchor = 0;
+		size_t i = 0;
+
+		while (i + MinMatch <= size) {
+			uint32_t v = read32(src+i);
+			uint h = hash(v);
+			size_t candidate = table[h];
+			table[h] = i+1;
+
+			if (!candidate || i-(candidate-1) > MaxOffset || read32(src+candidate-1) != v) {
+				i++;
+				continue;
+			}
+
+			size_t from = candidate-1;
+			size_t match = MinMatch;
+			while (i+match < size && src[from+match] == src[i+match]) match++;
+
+			sequence(out, src+anchor, i-anchor, i-from, match);
+
+			i += match;
+			anchor = i;
+		}
+
+		sequence(out, src+anchor, size-anchor, 0, 0);
+		return out;
+	}
+
+	bool decompress(const char* data, size_t length, size_t size, std::string& out) {
+		out.resize(size);
+
+		const uint8_t* p = (const uint8_t*)data;
+		const uint8_t* end = p+length;
+		char* dst = out.data();
+		size_t at = 0;
+
+		auto extra = [&](size_t& n) {
+			for (uint8_t b = 255; b == 255; n += b) {
+				if (p >= end) return false;
+				b = *p++;
+			}
+			return true;
+		};
+
+		while (p < end) {
+			uint8_t token = *p++;
+
+			size_t count = token >> 4;
+			if (count == 15 && !extra(count)) return false;
+			if ((size_t)(end-p) < count || at+count > size) return false;
+			std::memcpy(dst+at, p, count);
+			at += count;
+			p += count;
+
+			// literals-only last sequence
+			if (p == end) break;
+
+			if (end-p < 2) return false;
+			size_t offset = p[0] | (p[1] << 8);
+			p += 2;
+
+			size_t match = token & 15;
+			if (match == 15 && !extra(match)) return false;
+			match += MinMatch;
+
+			if (!offset || offset > at || at+match > size) return false;
+
+			if (offset >= match) {
+				std::memcpy(dst+at, dst+at-offset, match);
+				at += match;
+				continue;
+			}
+
+			// overlapping: a short run repeating itself
+			for (size_t j = 0; j < match; j++, at++) {
+				dst[at] = dst[at-offset];
+			}
+		}
+
+		return at == size;
+	}
+}
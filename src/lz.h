@@ -0,0 +1,18 @@
+#pragma once
+
+// Small LZ77 byte codec in the style of LZ4's block format, for save data
+// that is mostly runs and repeats (see Save chunk deltas). Single pass, no
+// entropy coding: fast both ways, modest ratio.
+
+// A block is a series of sequences: a token byte (literal count in the high
+// nibble, match length minus 4 in the low), extra length bytes for either
+// nibble that reads 15, the literals, then a 16-bit offset back into the
+// output for the match. The last sequence is literals only.
+
+#include <string>
+
+namespace LZ {
+	std::string compress(const std::string& in);
+	// false on malformed input or if the result isn't exactly size bytes
+	bool decompress(const char* data, size_t length, size_t size, std::string& out);
+}
@@ -323,6 +323,20 @@ void MainCamera::update(bool worldFocused) {
 			}
 
 			placingFits = !placing || placing->fits();
+
+			path.open.clear();
+			path.closed.clear();
+			path.shown = Path::jobs.size() > 0;
+
+			if (path.shown) {
+				Path* job = Path::jobs.front();
+				path.target = job->target;
+
+				for (auto& n: job->nodes) {
+					Path::Node* node = &n;
+					(job->inOpenSet(node) ? path.open: path.closed).push_back(node->point);
+				}
+			}
 		});
 
 		for (auto ge: entities) {
@@ -483,6 +497,7 @@ void MainCamera::draw() {
 
 				if (!ge->ghost && ge->spec->vehicle && hovering && ge->id == hovering->id) {
 					Sim::locked([&]() {
+						if (!Entity::exists(ge->id)) return;
 						Entity& en = Entity::get(ge->id);
 						Vehicle& vehicle = en.vehicle();
 						Point p = en.pos;
@@ -543,6 +558,7 @@ void MainCamera::draw() {
 
 				if (!ge->ghost && ge->spec->projector) {
 					Sim::locked([&]() {
+						if (!Entity::exists(ge->id)) return;
 						Projector& projector = Projector::get(ge->id);
 
 						if (projector.iid && hd) {
@@ -621,6 +637,7 @@ void MainCamera::draw() {
 
 				if (hovering->spec->pipe) {
 					Sim::locked([&]() {
+						if (!Entity::exists(hovering->id)) return;
 						Entity& en = Entity::get(hovering->id);
 						for (Point p: en.pipe().pipeConnections()) {
 							DrawCube(p, 0.25f, 0.25f, 0.25f, RED);
@@ -636,13 +653,16 @@ void MainCamera::draw() {
 				}
 
 				if (hovering->spec->crafter) {
-					Entity& en = Entity::get(hovering->id);
-					for (Point p: en.crafter().pipeInputConnections()) {
-						DrawCube(p, 0.25f, 0.25f, 0.25f, GREEN);
-					}
-					for (Point p: en.crafter().pipeOutputConnections()) {
-						DrawCube(p, 0.25f, 0.25f, 0.25f, RED);
-					}
+					Sim::locked([&]() {
+						if (!Entity::exists(hovering->id)) return;
+						Entity& en = Entity::get(hovering->id);
+						for (Point p: en.crafter().pipeInputConnections()) {
+							DrawCube(p, 0.25f, 0.25f, 0.25f, GREEN);
+						}
+						for (Point p: en.crafter().pipeOutputConnections()) {
+							DrawCube(p, 0.25f, 0.25f, 0.25f, RED);
+						}
+					});
 				}
 
 				if (hovering->spec->turret) {
@@ -651,10 +671,11 @@ void MainCamera::draw() {
 
 				if (hovering->spec->unveyor) {
 					Sim::locked([&]() {
+						if (!Entity::exists(hovering->id)) return;
 						Entity& en = Entity::get(hovering->id);
 						drawBox(en.unveyor().range(), Point::South, YELLOW);
 
-						if (en.unveyor().partner) {
+						if (en.unveyor().partner && Entity::exists(en.unveyor().partner)) {
 							Entity& ep = Entity::get(en.unveyor().partner);
 							drawBox(en.spec->southBox(en.pos), en.dir, YELLOW);
 							drawBox(ep.spec->southBox(ep.pos), ep.dir, YELLOW);
@@ -664,10 +685,11 @@ void MainCamera::draw() {
 
 				if (hovering->spec->pipeUnderground) {
 					Sim::locked([&]() {
+						if (!Entity::exists(hovering->id)) return;
 						Entity& en = Entity::get(hovering->id);
 						drawBox(en.pipe().undergroundRange(), Point::South, YELLOW);
 
-						if (en.pipe().partner) {
+						if (en.pipe().partner && Entity::exists(en.pipe().partner)) {
 							Entity& ep = Entity::get(en.pipe().partner);
 							drawBox(en.spec->southBox(en.pos), en.dir, YELLOW);
 							drawBox(ep.spec->southBox(ep.pos), ep.dir, YELLOW);
@@ -732,20 +754,18 @@ void MainCamera::draw() {
 				}
 			}
 
-			if (Path::jobs.size() > 0) {
-				Path* job = Path::jobs.front();
-				DrawCube(job->target, 0.5f, 0.5f, 0.5f, GOLD);
+			if (path.shown) {
+				DrawCube(path.target, 0.5f, 0.5f, 0.5f, GOLD);
 
 				minivec<Mat4> reds;
 				minivec<Mat4> greens;
 
-				for (auto pair: job->nodes) {
-					Path::Node* node = pair.second;
-					if (job->inOpenSet(node)) {
-						greens.push_back(Mat4::translate(node->point.x, node->point.y, node->point.z));
-					} else {
-						reds.push_back(Mat4::translate(node->point.x, node->point.y, node->point.z));
-					}
+				for (auto& p: path.open) {
+					greens.push_back(Mat4::translate(p.x, p.y, p.z));
+				}
+
+				for (auto& p: path.closed) {
+					reds.push_back(Mat4::translate(p.x, p.y, p.z));
 				}
 
 				if (reds.size() > 0)
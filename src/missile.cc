@@ -2,14 +2,28 @@
 #include "sim.h"
 #include "entity.h"
 #include "missile.h"
+#include "jobs.h"
 
 void Missile::reset() {
 	all.clear();
 }
 
 void Missile::tick() {
+	// transient and never pointed at between ticks, so safe to repack
+	if (all.sparse()) all.compact();
+
+	static std::vector<Missile*> missiles;
+	missiles.clear();
 	for (auto& missile: all) {
-		missile.update();
+		missiles.push_back(&missile);
+	}
+
+	Jobs::parallel(missiles.size(), 64, [&](uint begin, uint end) {
+		for (uint i = begin; i < end; i++) missiles[i]->plan();
+	});
+
+	for (auto missile: missiles) {
+		missile->update();
 	}
 }
 
@@ -18,6 +32,8 @@ Missile& Missile::create(uint id) {
 	missile.id = id;
 	missile.tid = 0;
 	missile.attacking = false;
+	missile.moving = false;
+	missile.impact = false;
 	missile.aim = Point::Zero;
 	return missile;
 }
@@ -30,13 +46,16 @@ void Missile::destroy() {
 	all.erase(id);
 }
 
-void Missile::update() {
+// Parallel phase: work out where to go, writing only to this Missile
+void Missile::plan() {
+	moving = false;
+
 	Entity& en = Entity::get(id);
 	if (en.isGhost()) return;
 	if (!attacking) return;
 
-	bool impact = false;
-	Point next = aim;
+	impact = false;
+	next = aim;
 
 	if (en.spec->missileBallistic) {
 		Point dir = aim - en.pos;
@@ -70,12 +89,22 @@ void Missile::update() {
 		}
 	}
 
+	moving = true;
+}
+
+// Serial phase: move and maybe detonate
+void Missile::update() {
+	if (!moving) return;
+	moving = false;
+
+	Entity& en = Entity::get(id);
 	en.lookAt(next);
 	en.move(next);
 
 	if (impact) en.explode();
 }
 
+
 void Missile::attack(uint aid) {
 	attacking = true;
 	tid = aid;
@@ -21,7 +21,13 @@ struct Missile {
 	Point aim;
 	bool attacking;
 
+	// per-tick plan, see Sim::update
+	bool moving;
+	bool impact;
+	Point next;
+
 	void destroy();
+	void plan();
 	void update();
 	void attack(uint tid);
 };
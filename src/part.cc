@@ -80,6 +80,12 @@ Mesh Thing::loadSTL(std::string stl) {
 		return STLs[stl];
 	}
 
+	if (rlHeadless) {
+		Mesh mesh; ZERO(mesh);
+		STLs[stl] = mesh;
+		return mesh;
+	}
+
 	struct Triangle {
 		size_t count;
 		Vector3 vertices[3];
@@ -256,7 +262,7 @@ Thing& Thing::smooth() {
 		}
 
 		// 2=normals, see rlUpdateMeshAt()
-		rlUpdateMesh(*mesh, 2, mesh->vertexCount);
+		if (!rlHeadless) rlUpdateMesh(*mesh, 2, mesh->vertexCount);
 	};
 
 	normals(&meshHD);
@@ -0,0 +1,497 @@
+#include "common.h"
+#include "path-graph.h"
+#include "entity.h"
+#include <limits>
+#include <queue>
+#include <cmath>
+#include <set>
+
+namespace {
+	const float inf = std::numeric_limits<float>::infinity();
+	const int size = Chunk::size;
+
+	// border tile offsets across each side
+	const int sideX[4] = {-1, 1, 0, 0};
+	const int sideZ[4] = { 0, 0,-1, 1};
+
+	uint opposite(uint side) {
+		return side ^ 1;
+	}
+}
+
+PathGraph* PathGraph::get(float clearance) {
+	if (!all.count(clearance)) {
+		all[clearance] = new PathGraph(clearance);
+	}
+	return all[clearance];
+}
+
+// Marks regions touched by box for rebuilding, and stamps its cells for
+// the route caches. The region margin covers tiles whose clearance reaches
+// into box; cached routes apply their own margin when recording cells.
+void PathGraph::invalidate(Box box) {
+	edits++;
+	for (auto xy: gridwalk(cell, box)) {
+		versions[xy] = edits;
+	}
+
+	for (auto& [_,graph]: all) {
+		Box b = box.grow(graph->clearance + 1.0f);
+		for (auto xy: gridwalk(size, b)) {
+			auto it = graph->regions.find(xy);
+			if (it != graph->regions.end()) {
+				it->second->walkDirty = true;
+			}
+		}
+	}
+}
+
+void PathGraph::reset() {
+	for (auto& [_,graph]: all) {
+		delete graph;
+	}
+	all.clear();
+}
+
+bool PathGraph::mobile(Spec* spec) {
+	return spec->vehicle || spec->drone || spec->missile || spec->explosion || spec->ropewayBucket;
+}
+
+PathGraph::XY PathGraph::chunkOf(Point p) {
+	return Chunk::tileXYtoChunkXY(std::floor(p.x), std::floor(p.z));
+}
+
+PathGraph::PathGraph(float c) {
+	clearance = c;
+}
+
+PathGraph::~PathGraph() {
+	for (auto& [_,region]: regions) {
+		delete region;
+	}
+}
+
+bool PathGraph::walkable(Point p) {
+	int x = std::floor(p.x);
+	int z = std::floor(p.z);
+	auto [ox,oz] = Chunk::tileXYtoOffsetXY(x, z);
+	return walked(chunkOf(p))->walkable[oz*size+ox];
+}
+
+PathGraph::Region* PathGraph::walked(XY xy) {
+	auto it = regions.find(xy);
+	Region* r = it == regions.end() ? nullptr: it->second;
+	if (!r) {
+		r = new Region;
+		r->xy = xy;
+		regions[xy] = r;
+	}
+	if (r->walkDirty) {
+		walk(r);
+	}
+	return r;
+}
+
+PathGraph::Region* PathGraph::region(XY xy) {
+	Region* r = walked(xy);
+	if (r->linkDirty) {
+		link(r);
+	}
+	return r;
+}
+
+// A tile is walkable when every tile within clearance of its centroid is
+// land and no fixed entity covers the centroid, the same tests
+// Vehicle::Route::getNeighbours applies. While any chunk in reach is not
+// generated the region stays dirty and is rebuilt on next use.
+void PathGraph::walk(Region* r) {
+	int m = std::ceil(clearance) + 1;
+	int x0 = r->xy.x*size;
+	int z0 = r->xy.y*size;
+	int span = size + m*2;
+
+	std::vector<bool> land(span*span);
+	bool complete = true;
+
+	for (int cz = r->xy.y-1; cz <= r->xy.y+1; cz++) {
+		for (int cx = r->xy.x-1; cx <= r->xy.x+1; cx++) {
+			Chunk* chunk = Chunk::tryGet(cx, cz);
+			if (!chunk) {
+				complete = false;
+				continue;
+			}
+
+			int tx0 = std::max(x0-m, cx*size);
+			int tz0 = std::max(z0-m, cz*size);
+			int tx1 = std::min(x0+size+m, (cx+1)*size);
+			int tz1 = std::min(z0+size+m, (cz+1)*size);
+
+			for (int z = tz0; z < tz1; z++) {
+				for (int x = tx0; x < tx1; x++) {
+					land[(z-z0+m)*span + (x-x0+m)] = chunk->tiles[z-cz*size][x-cx*size].isLand();
+				}
+			}
+		}
+	}
+
+	std::vector<bool> walkable(size*size);
+
+	for (int z = 0; z < size; z++) {
+		for (int x = 0; x < size; x++) {
+			Box b = Point(x0+x, 0, z0+z).tileCentroid().box().grow(clearance);
+			bool ok = true;
+			for (auto [tx,tz]: Chunk::walkTiles(b)) {
+				ok = ok && land[(tz-z0+m)*span + (tx-x0+m)];
+			}
+			walkable[z*size+x] = ok;
+		}
+	}
+
+	Box area = {x0 + size*0.5f, 0.0f, z0 + size*0.5f, (float)size, 1000.0f, (float)size};
+
+	for (auto eid: Entity::intersecting(area)) {
+		Entity& en = Entity::get(eid);
+		if (en.spec->vehicleStop || mobile(en.spec)) {
+			continue;
+		}
+		Box box = en.box();
+		for (auto [tx,tz]: Chunk::walkTiles(box)) {
+			if (tx < x0 || tz < z0 || tx >= x0+size || tz >= z0+size) continue;
+			if (box.contains(Point(tx, 0, tz).tileCentroid())) {
+				walkable[(tz-z0)*size + (tx-x0)] = false;
+			}
+		}
+	}
+
+	r->walkDirty = !complete;
+
+	if (walkable != r->walkable) {
+		r->walkable.swap(walkable);
+		r->linkDirty = true;
+		for (uint s = 0; s < 4; s++) {
+			auto it = regions.find({r->xy.x+sideX[s], r->xy.y+sideZ[s]});
+			if (it != regions.end()) {
+				it->second->linkDirty = true;
+			}
+		}
+	}
+}
+
+// Portals sit on runs of border tiles that are walkable on both sides: one
+// in the middle of a short run, one at each end of a longer run. Both
+// regions sharing a border find the same runs in the same order.
+void PathGraph::link(Region* r) {
+	int x0 = r->xy.x*size;
+	int z0 = r->xy.y*size;
+
+	r->portals.clear();
+
+	for (uint s = 0; s < 4; s++) {
+		Region* n = walked({r->xy.x+sideX[s], r->xy.y+sideZ[s]});
+
+		// tile i along side s, in this region and across the border
+		auto inner = [&](int i) -> std::pair<int,int> {
+			if (s == 0) return {0, i};
+			if (s == 1) return {size-1, i};
+			if (s == 2) return {i, 0};
+			return {i, size-1};
+		};
+
+		auto open = [&](int i) {
+			auto [ix,iz] = inner(i);
+			int ox = (ix + sideX[s] + size) % size;
+			int oz = (iz + sideZ[s] + size) % size;
+			return r->walkable[iz*size+ix] && n->walkable[oz*size+ox];
+		};
+
+		uint index = 0;
+
+		auto portal = [&](int i) {
+			auto [ix,iz] = inner(i);
+			r->portals.push_back({ .x = x0+ix, .z = z0+iz, .side = s, .index = index++, .costs = {} });
+		};
+
+		for (int i = 0; i < size; ) {
+			if (!open(i)) {
+				i++;
+				continue;
+			}
+			int j = i;
+			while (j < size && open(j)) j++;
+			if (j-i <= 8) {
+				portal((i+j-1)/2);
+			} else {
+				portal(i);
+				portal(j-1);
+			}
+			i = j;
+		}
+	}
+
+	uint count = r->portals.size();
+	for (auto& p: r->portals) {
+		p.costs.assign(count, inf);
+	}
+
+	// costs are symmetric, so each flood fills a row and a column
+	for (uint i = 0; i < count; i++) {
+		Portal& p = r->portals[i];
+		auto costs = flood(r, p.x, p.z);
+		for (uint j = i; j < count; j++) {
+			Portal& q = r->portals[j];
+			float cost = costs[(q.z-z0)*size + (q.x-x0)];
+			p.costs[j] = cost;
+			q.costs[i] = cost;
+		}
+	}
+
+	r->linkDirty = false;
+}
+
+// Dijkstra over a region's walkable tiles from tile x,z with 8-way moves;
+// the cost to reach each tile, row-major by z. Steps cost 10 or 14 so a
+// ring of 15 buckets can stand in for a priority queue.
+std::vector<float> PathGraph::flood(Region* r, int x, int z) {
+	int x0 = r->xy.x*size;
+	int z0 = r->xy.y*size;
+
+	const uint none = ~0u;
+	std::vector<uint> steps(size*size, none);
+	std::vector<float> costs(size*size, inf);
+
+	int start = (z-z0)*size + (x-x0);
+	if (!r->walkable[start]) return costs;
+
+	std::vector<int> buckets[15];
+	steps[start] = 0;
+	buckets[0].push_back(start);
+
+	uint pending = 1;
+	for (uint cost = 0; pending; cost++) {
+		auto& bucket = buckets[cost%15];
+		for (uint b = 0; b < bucket.size(); b++) {
+			int i = bucket[b];
+			pending--;
+			if (steps[i] != cost) continue;
+
+			int cx = i%size;
+			int cz = i/size;
+
+			for (int dz = -1; dz <= 1; dz++) {
+				for (int dx = -1; dx <= 1; dx++) {
+					if (!dx && !dz) continue;
+					int nx = cx+dx;
+					int nz = cz+dz;
+					if (nx < 0 || nz < 0 || nx >= size || nz >= size) continue;
+					int n = nz*size+nx;
+					if (!r->walkable[n]) continue;
+					uint next = cost + (dx && dz ? 14: 10);
+					if (next < steps[n]) {
+						steps[n] = next;
+						buckets[next%15].push_back(n);
+						pending++;
+					}
+				}
+			}
+		}
+		bucket.clear();
+	}
+
+	for (int i = 0; i < size*size; i++) {
+		if (steps[i] != none) costs[i] = steps[i] * 0.1f;
+	}
+
+	return costs;
+}
+
+// A* over the portal graph plus two temporary nodes for origin and target,
+// joined to the portals of their regions by a flood. Ties break on node
+// number, which follows discovery order, so results are deterministic.
+bool PathGraph::search(Point origin, Point target, Corridor& corridor) {
+	corridor = Corridor();
+
+	XY oxy = chunkOf(origin);
+	XY txy = chunkOf(target);
+
+	if (!walkable(origin) || !walkable(target)) {
+		return false;
+	}
+
+	Region* ro = region(oxy);
+	Region* rt = region(txy);
+
+	auto tileCost = [&](const std::vector<float>& costs, Region* r, Point p) {
+		int x = (int)std::floor(p.x) - r->xy.x*size;
+		int z = (int)std::floor(p.z) - r->xy.y*size;
+		return costs[z*size+x];
+	};
+
+	auto fromOrigin = flood(ro, std::floor(origin.x), std::floor(origin.z));
+	auto fromTarget = flood(rt, std::floor(target.x), std::floor(target.z));
+
+	// node 0 is the origin, node 1 the target, then portals as discovered
+	struct Node {
+		XY xy;
+		uint portal;
+		Point point;
+		float g;
+		uint cameFrom;
+		bool closed;
+	};
+
+	std::vector<Node> nodes;
+	std::map<std::pair<XY,uint>,uint> numbers;
+
+	nodes.push_back({oxy, 0, origin, 0.0f, 0, false});
+	nodes.push_back({txy, 0, target, inf, 0, false});
+
+	auto number = [&](Region* r, uint p) {
+		auto key = std::make_pair(r->xy, p);
+		auto it = numbers.find(key);
+		if (it != numbers.end()) return it->second;
+		Portal& portal = r->portals[p];
+		uint n = nodes.size();
+		nodes.push_back({r->xy, p, Point(portal.x, 0, portal.z).tileCentroid(), inf, 0, false});
+		numbers[key] = n;
+		return n;
+	};
+
+	typedef std::pair<float,uint> entry;
+	std::priority_queue<entry,std::vector<entry>,std::greater<entry>> open;
+
+	auto relax = [&](uint from, uint to, float cost) {
+		if (cost == inf || nodes[to].closed) return;
+		float g = nodes[from].g + cost;
+		if (g < nodes[to].g) {
+			nodes[to].g = g;
+			nodes[to].cameFrom = from;
+			open.push({g + nodes[to].point.distance(target), to});
+		}
+	};
+
+	open.push({origin.distance(target), 0});
+
+	while (open.size()) {
+		auto [_,n] = open.top();
+		open.pop();
+
+		if (nodes[n].closed) continue;
+		nodes[n].closed = true;
+
+		if (n == 1) break;
+
+		if (n == 0) {
+			for (uint p = 0; p < ro->portals.size(); p++) {
+				Portal& portal = ro->portals[p];
+				relax(0, number(ro, p), tileCost(fromOrigin, ro, Point(portal.x, 0, portal.z)));
+			}
+			if (oxy == txy) {
+				relax(0, 1, tileCost(fromOrigin, ro, target));
+			}
+			continue;
+		}
+
+		Region* r = region(nodes[n].xy);
+		uint p = nodes[n].portal;
+		Portal portal = r->portals[p];
+
+		for (uint q = 0; q < r->portals.size(); q++) {
+			if (q != p) relax(n, number(r, q), portal.costs[q]);
+		}
+
+		// step across the border to the matching portal
+		Region* across = region({r->xy.x+sideX[portal.side], r->xy.y+sideZ[portal.side]});
+		for (uint q = 0; q < across->portals.size(); q++) {
+			Portal& other = across->portals[q];
+			if (other.side == opposite(portal.side) && other.index == portal.index) {
+				relax(n, number(across, q), 1.0f);
+				break;
+			}
+		}
+
+		if (r->xy == txy) {
+			relax(n, 1, tileCost(fromTarget, rt, nodes[n].point));
+		}
+	}
+
+	if (!nodes[1].closed) {
+		return false;
+	}
+
+	std::vector<uint> route;
+	for (uint n = 1; n != 0; n = nodes[n].cameFrom) {
+		route.push_back(n);
+	}
+	route.push_back(0);
+
+	float total = nodes[1].g;
+
+	for (auto it = route.rbegin(); it != route.rend(); it++) {
+		Node& node = nodes[*it];
+		corridor.points.push_back(node.point);
+		corridor.chunks.push_back(node.xy);
+		corridor.remaining.push_back(total - node.g);
+	}
+
+	return true;
+}
+
+bool PathGraph::recall(Point origin, Point target, std::vector<Point>& result) {
+	RouteKey key = {Path::tileKey(origin), Path::tileKey(target)};
+	auto it = routes.find(key);
+	if (it == routes.end()) return false;
+
+	Cached& cached = it->second;
+	byUse.erase(cached.used);
+
+	for (auto xy: cached.cells) {
+		auto vit = versions.find(xy);
+		if (vit != versions.end() && vit->second > cached.edits) {
+			routes.erase(it);
+			return false;
+		}
+	}
+
+	cached.used = ++uses;
+	byUse[cached.used] = key;
+	result = cached.result;
+	return true;
+}
+
+// since is the edit count when the search began, so an edit landing while
+// it ran also keeps the route out of the cache.
+void PathGraph::remember(Point origin, Point target, const std::vector<Point>& result, uint64_t since) {
+	std::set<XY> cells;
+	Point a = origin;
+	for (Point b: result) {
+		for (auto xy: gridwalk(cell, Box(a, b).grow(clearance + 1.0f))) {
+			cells.insert(xy);
+		}
+		a = b;
+	}
+
+	for (auto xy: cells) {
+		auto it = versions.find(xy);
+		if (it != versions.end() && it->second > since) return;
+	}
+
+	RouteKey key = {Path::tileKey(origin), Path::tileKey(target)};
+
+	auto it = routes.find(key);
+	if (it != routes.end()) {
+		byUse.erase(it->second.used);
+	} else
+	if (routes.size() >= cacheLimit && byUse.size()) {
+		auto lru = byUse.begin();
+		routes.erase(lru->second);
+		byUse.erase(lru);
+	}
+
+	routes[key] = {
+		.result = result,
+		.cells = std::vector<XY>(cells.begin(), cells.end()),
+		.edits = since,
+		.used = ++uses,
+	};
+	byUse[uses] = key;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Hierarchical view of the map for long vehicle routes (HPA*). Each Chunk
+// is a region with portals wherever walkable tiles meet across its borders,
+// plus the cost between every pair of portals inside it. A route searches
+// this small graph first, then refines at tile level only within the chunks
+// the portal route passes through (see Vehicle::Route).
+
+// Walkability depends on clearance, so there is one graph per clearance. It
+// ignores things that move (vehicles, drones, missiles...) which the tile
+// search still avoids. Regions are rebuilt lazily, the next time a route
+// needs them, after entities are indexed or the terrain changes.
+
+// Each graph also caches finished routes by origin and target tile, so
+// patrolling vehicles don't search the same leg every lap. Map edits stamp
+// the cells they touch, and a cached route is only reused while no cell
+// along it has been stamped since its search began.
+
+struct PathGraph;
+
+#include "point.h"
+#include "box.h"
+#include "chunk.h"
+#include "spec.h"
+#include "path.h"
+#include <map>
+#include <vector>
+
+struct PathGraph {
+	typedef Chunk::XY XY;
+
+	struct Portal {
+		int x, z;
+		// border: 0 -x, 1 +x, 2 -z, 3 +z
+		uint side;
+		// position among the portals on that border; the neighbouring
+		// region numbers its side of the border the same way
+		uint index;
+		// to each portal in the region, infinity when unreachable
+		std::vector<float> costs;
+	};
+
+	struct Region {
+		XY xy;
+		bool walkDirty = true;
+		bool linkDirty = true;
+		// Chunk::size squared, row-major by z
+		std::vector<bool> walkable;
+		std::vector<Portal> portals;
+	};
+
+	// Portal route from origin to target: tile centroids, the chunk each is
+	// in, and the cost left from each to the target.
+	struct Corridor {
+		std::vector<Point> points;
+		std::vector<XY> chunks;
+		std::vector<float> remaining;
+	};
+
+	struct Cached {
+		std::vector<Point> result;
+		std::vector<XY> cells;
+		uint64_t edits;
+		uint64_t used;
+	};
+
+	// cells for edit stamps, the same size as Entity::grid's
+	static const int cell = 32;
+	static inline uint64_t edits = 0;
+	static inline std::map<XY,uint64_t> versions;
+	static inline uint cacheLimit = 4096;
+
+	static inline std::map<float,PathGraph*> all;
+	static PathGraph* get(float clearance);
+	static void invalidate(Box box);
+	static void reset();
+	static bool mobile(Spec* spec);
+	static XY chunkOf(Point p);
+
+	float clearance;
+	std::map<XY,Region*> regions;
+	typedef std::pair<uint64_t,uint64_t> RouteKey;
+	std::map<RouteKey,Cached> routes;
+	// routes by Cached::used, least recently used first
+	std::map<uint64_t,RouteKey> byUse;
+	uint64_t uses = 0;
+
+	PathGraph(float clearance);
+	~PathGraph();
+
+	bool walkable(Point p);
+	bool search(Point origin, Point target, Corridor& corridor);
+	bool recall(Point origin, Point target, std::vector<Point>& result);
+	void remember(Point origin, Point target, const std::vector<Point>& result, uint64_t since);
+
+	Region* walked(XY xy);
+	Region* region(XY xy);
+	void walk(Region* region);
+	void link(Region* region);
+	std::vector<float> flood(Region* region, int x, int z);
+};
@@ -0,0 +1,151 @@
+#include "common.h"
+#include "path.h"
+#include <random>
+#include <chrono>
+
+// Long cross-map routes on a synthetic maze: rows of walls with a few
+// random gaps, so the search has to zig-zag and the open set grows large.
+
+struct Maze {
+	int size = 512;
+	std::vector<bool> walls;
+
+	Maze(int s, uint seed) {
+		size = s;
+		walls.resize(size*size);
+		std::mt19937 rng(seed);
+		for (int z = 8; z < size; z += 8) {
+			for (int x = 0; x < size; x++) {
+				walls[z*size+x] = true;
+			}
+			for (int g = 0; g < 3; g++) {
+				walls[z*size+(rng()%size)] = false;
+			}
+		}
+	}
+
+	bool open(int x, int z) {
+		return x >= 0 && z >= 0 && x < size && z < size && !walls[z*size+x];
+	}
+};
+
+struct MazeRoute: Path {
+	Maze* maze;
+
+	MazeRoute(Maze* m) : Path() {
+		maze = m;
+	}
+
+	std::vector<Point> getNeighbours(Point p) {
+		std::vector<Point> points;
+		int px = std::floor(p.x);
+		int pz = std::floor(p.z);
+		for (int dz = -1; dz <= 1; dz++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				if (!dx && !dz) continue;
+				if (!maze->open(px+dx, pz+dz)) continue;
+				if (!maze->open(px+dx, pz) || !maze->open(px, pz+dz)) continue;
+				points.push_back(Point(px+dx, 0, pz+dz).tileCentroid());
+			}
+		}
+		return points;
+	}
+
+	double calcCost(Point a, Point b) {
+		return a.distance(b);
+	}
+
+	double calcHeuristic(Point p) {
+		return p.distance(target);
+	}
+
+	bool rayCast(Point a, Point b) {
+		return false;
+	}
+};
+
+int main(int argc, char const *argv[]) {
+
+	int size = 512;
+	uint routes = 5;
+	int budget = -1;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--size" && i+1 < argc) {
+			size = std::max(16, std::atoi(argv[++i]));
+		}
+		if (std::string(argv[i]) == "--routes" && i+1 < argc) {
+			routes = std::max(1, std::atoi(argv[++i]));
+		}
+		if (std::string(argv[i]) == "--budget" && i+1 < argc) {
+			budget = std::max(0, std::atoi(argv[++i]));
+		}
+	}
+
+	// With --budget all routes run together through the Path::tick()
+	// scheduler, reporting the tick each one finished on.
+	if (budget >= 0) {
+		Path::budget = budget;
+
+		std::vector<Maze*> mazes;
+		std::vector<MazeRoute*> jobs;
+
+		for (uint r = 0; r < routes; r++) {
+			mazes.push_back(new Maze(size, r+1));
+			jobs.push_back(new MazeRoute(mazes.back()));
+			jobs.back()->origin = Point(0, 0, 0).tileCentroid();
+			jobs.back()->target = Point(size-1, 0, size-1).tileCentroid();
+			jobs.back()->submit();
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<uint> finished(routes, 0);
+		for (uint tick = 1; Path::jobs.size(); tick++) {
+			Path::tick();
+			for (uint r = 0; r < routes; r++) {
+				if (jobs[r]->done && !finished[r]) finished[r] = tick;
+			}
+		}
+
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+		long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+		for (uint r = 0; r < routes; r++) {
+			notef("route %u: %s, finished tick %u", r, jobs[r]->success ? "found": "failed", finished[r]);
+			delete jobs[r];
+			delete mazes[r];
+		}
+
+		notef("%u routes, budget %d us, %lld us", routes, budget, microseconds);
+		return 0;
+	}
+
+	for (uint r = 0; r < routes; r++) {
+		Maze maze(size, r+1);
+
+		MazeRoute route(&maze);
+		route.origin = Point(0, 0, 0).tileCentroid();
+		route.target = Point(size-1, 0, size-1).tileCentroid();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		route.submit();
+		Path::jobs.clear();
+
+		uint steps = 0;
+		while (!route.done) {
+			route.update();
+			steps++;
+		}
+
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+		long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+		notef("route %u: %s, %u steps, %u nodes, %u points, %lld us",
+			r, route.success ? "found": "failed", steps, route.nodes.size(), (uint)route.result.size(), microseconds
+		);
+	}
+
+	return 0;
+}
@@ -1,18 +1,105 @@
 #include "common.h"
 #include "path.h"
 #include <limits>
+#include <cmath>
+#include <chrono>
 
 void Path::tick() {
-	for (int i = 0; i < 10; i++) {
-		if (jobs.size() > 0) {
+	if (background()) {
+		for (Path* job: jobs) {
+			job->prepare();
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		queue.splice(queue.end(), jobs);
+		wakeup.notify_one();
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto limit = std::chrono::microseconds(budget);
+
+	// Each job gets a slice then goes to the back of the queue, so one long
+	// search can't starve the rest. A round cut short by the budget resumes
+	// next tick from where it stopped.
+	while (jobs.size()) {
+		for (uint n = jobs.size(); n > 0 && jobs.size(); n--) {
 			Path* job = jobs.front();
+			jobs.pop_front();
 
-			job->update();
+			for (uint i = 0; i < slice && !job->done; i++) {
+				job->update();
+			}
 
-			if (job->done) {
-				jobs.pop_front();
+			if (!job->done) {
+				jobs.push_back(job);
 			}
+
+			if (budget && std::chrono::steady_clock::now() - start > limit) {
+				return;
+			}
+		}
+
+		if (!budget) {
+			return;
+		}
+	}
+}
+
+void Path::start() {
+	if (background()) return;
+	stopping = false;
+	worker = std::thread(work);
+}
+
+void Path::stop() {
+	if (!background()) return;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+		wakeup.notify_one();
+	}
+	worker.join();
+	// unfinished jobs go back to the sim thread
+	jobs.splice(jobs.begin(), queue);
+}
+
+bool Path::background() {
+	return worker.joinable();
+}
+
+void Path::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wakeup.wait(lock, [&]() { return stopping || queue.size(); });
+		if (stopping) break;
+
+		Path* job = queue.front();
+		queue.pop_front();
+		running = job;
+
+		lock.unlock();
+		for (uint i = 0; i < slice && !job->done; i++) {
+			job->update();
+		}
+		lock.lock();
+
+		if (!job->done) {
+			queue.push_back(job);
 		}
+
+		running = nullptr;
+		idle.notify_all();
+	}
+}
+
+// Owners must withdraw a job before deleting it, done or not, so the worker
+// is never left holding a freed pointer.
+void Path::withdraw(Path* job) {
+	jobs.remove(job);
+	if (background()) {
+		std::unique_lock<std::mutex> lock(mutex);
+		queue.remove(job);
+		idle.wait(lock, [&]() { return running != job; });
 	}
 }
 
@@ -22,6 +109,9 @@ Path::Path() {
 Path::~Path() {
 }
 
+void Path::prepare() {
+}
+
 void Path::submit() {
 	Node* node = getNode(origin);
 	node->gScore = 0;
@@ -30,28 +120,89 @@ void Path::submit() {
 	jobs.push_back(this);
 }
 
+// Tile coordinates packed as y:8 x:24 z:32, then scrambled with an
+// invertible mix so neighbouring tiles don't crowd one part of the flat
+// node table. Points within a tile share a node; getNeighbours() already
+// snaps to tile centroids, or to the origin or target within their tiles.
+uint64_t Path::tileKey(Point point) {
+	uint64_t x = (uint64_t)(int64_t)std::floor(point.x) & 0xffffff;
+	uint64_t y = (uint64_t)(int64_t)std::floor(point.y) & 0xff;
+	uint64_t z = (uint64_t)(int64_t)std::floor(point.z) & 0xffffffff;
+	uint64_t h = (y << 56) | (x << 32) | z;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
 Path::Node* Path::getNode(Point point) {
 	double inf = std::numeric_limits<double>::infinity();
 
-	if (nodes.count(point) == 0) {
-		Node* node = &pool.request();
+	uint64_t key = tileKey(point);
+
+	if (!nodes.has(key)) {
+		Node* node = &nodes[key];
 		node->point = point;
 		node->gScore = inf;
 		node->fScore = inf;
 		node->cameFrom = NULL;
-		nodes[point] = node;
+		return node;
 	}
 
-	return nodes[point];
+	return &nodes.refer(key);
+}
+
+// Heap order: lowest fScore, ties broken by point so results don't depend
+// on the order neighbours were pushed.
+bool Path::before(Path::Node* a, Path::Node* b) {
+	if (a->fScore != b->fScore) return a->fScore < b->fScore;
+	return a->point < b->point;
+}
+
+void Path::heapUp(uint i) {
+	Node* node = opens[i];
+	while (i > 0) {
+		uint parent = (i-1)/2;
+		if (!before(node, opens[parent])) break;
+		opens[i] = opens[parent];
+		opens[i]->heap = i;
+		i = parent;
+	}
+	opens[i] = node;
+	node->heap = i;
+}
+
+void Path::heapDown(uint i) {
+	Node* node = opens[i];
+	uint n = opens.size();
+	for (;;) {
+		uint child = i*2+1;
+		if (child >= n) break;
+		if (child+1 < n && before(opens[child+1], opens[child])) child++;
+		if (!before(opens[child], node)) break;
+		opens[i] = opens[child];
+		opens[i]->heap = i;
+		i = child;
+	}
+	opens[i] = node;
+	node->heap = i;
 }
 
 bool Path::inOpenSet(Path::Node* node) {
 	return node->set == 1;
 }
 
+// Push, or decrease-key if already open (fScore only ever improves)
 void Path::toOpenSet(Path::Node* node) {
+	if (inOpenSet(node)) {
+		heapUp(node->heap);
+		return;
+	}
 	node->set = 1;
-	opens[node->point] = node;
+	opens.push_back(node);
+	heapUp(opens.size()-1);
 }
 
 bool Path::inClosedSet(Path::Node* node) {
@@ -59,35 +210,32 @@ bool Path::inClosedSet(Path::Node* node) {
 }
 
 void Path::toClosedSet(Path::Node* node) {
-	opens.erase(node->point);
+	if (inOpenSet(node)) {
+		uint i = node->heap;
+		opens[i] = opens.back();
+		opens[i]->heap = i;
+		opens.pop_back();
+		if (i < opens.size()) {
+			heapUp(i);
+			heapDown(opens[i]->heap);
+		}
+	}
 	node->set = 2;
 }
 
 void Path::update() {
-	Node* current = candidate;
-	candidate = NULL;
-
-	if (!current) {
-		for (auto pair: opens) {
-			Node *check = pair.second;
-			if (!current || check->fScore < current->fScore) {
-				candidate = current;
-				current = check;
-			}
-		}
-	}
+	Node* current = opens.size() ? opens.front(): NULL;
 
 	// not possible?
 	if (!current) {
-		done = true;
 		success = false;
 		result.clear();
+		done = true;
 		return;
 	}
 
 	// arrived?
 	if (current->point == target) {
-		done = true;
 		success = true;
 
 		std::vector<Point> selected;
@@ -120,6 +268,8 @@ void Path::update() {
 			}
 		}
 
+		// last, so an owner polling from another thread sees a whole result
+		done = true;
 		return;
 	}
 
@@ -151,15 +301,6 @@ void Path::update() {
 				double endCost = calcHeuristic(neighbour->point);
 				neighbour->fScore = gScoreTentative + endCost;
 				toOpenSet(neighbour);
-
-				// `current` had the lowest fScore this pass. Therefore any neighbour that
-				// has a lower fScore is probably a good candidate for the next pass. Each
-				// time we cache a candidate we avoid an extra O(n) pass over the open set.
-				if ((candidate == NULL && neighbour->fScore < current->fScore)
-					|| (candidate != NULL && neighbour->fScore < candidate->fScore)) {
-
-					candidate = neighbour;
-				}
 			}
 		}
 	}
@@ -2,48 +2,89 @@
 
 // A* (like) path-finder.
 
+// Nodes live in a slabmap keyed on packed tile coordinates with a flat
+// open-addressed index, and the open set is a binary heap that tracks each
+// node's position so a better route to an open node is a decrease-key.
+
+// Jobs are scheduled round-robin, a slice of node expansions each, until the
+// per-tick budget runs out. Alternatively a background worker thread runs
+// them against whatever read-only state prepare() captured on the sim
+// thread; owners poll done either way.
+
 #include "point.h"
-#include "slabpool.h"
-#include <map>
+#include "slabmap.h"
 #include <list>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 struct Path {
 	static inline std::list<Path*> jobs;
 	static void tick();
 
+	// microseconds of path-finding per tick; zero runs exactly one round of
+	// slices per tick, which is deterministic
+	static inline std::atomic<uint> budget = 1000;
+
+	// node expansions per job per turn
+	static inline uint slice = 32;
+
+	static void start();
+	static void stop();
+	static bool background();
+	static void withdraw(Path*);
+
+	static inline std::thread worker;
+	static inline std::mutex mutex;
+	static inline std::condition_variable wakeup;
+	static inline std::condition_variable idle;
+	static inline std::list<Path*> queue;
+	static inline Path* running = nullptr;
+	static inline bool stopping = false;
+	static void work();
+
 	struct Node {
+		uint64_t tile = 0;
 		Point point = {0,0,0};
 		double gScore = 0.0;
 		double fScore = 0.0;
 		Node* cameFrom = NULL;
 		int set = 0;
+		uint heap = 0;
 	};
 
-	slabpool<Node> pool;
+	static uint64_t tileKey(Point point);
 
 	Point origin = {0,0,0};
 	Point target = {0,0,0};
-	Node* candidate = NULL;
-	std::map<Point,Node*> nodes;
-	std::map<Point,Node*> opens;
+	slabmap<Node,&Node::tile,1024,slabflat> nodes;
+	std::vector<Node*> opens;
 
-	bool done = false;
+	std::atomic<bool> done = false;
 	bool success = false;
 	bool cancel = false;
 	std::vector<Point> result;
 
 	Path();
 	virtual ~Path();
-	void submit();
+	virtual void submit();
 	Node* getNode(Point point);
 	void update();
 
+	// called on the sim thread before the job moves to the worker
+	virtual void prepare();
+
 	bool inOpenSet(Node*);
 	void toOpenSet(Node*);
 	bool inClosedSet(Node*);
 	void toClosedSet(Node*);
 
+	bool before(Node*,Node*);
+	void heapUp(uint);
+	void heapDown(uint);
+
 	virtual std::vector<Point> getNeighbours(Point) = 0;
 	virtual double calcCost(Point,Point) = 0;
 	virtual double calcHeuristic(Point) = 0;
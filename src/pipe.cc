@@ -32,14 +32,89 @@ void Pipe::destroy() {
 
 void Pipe::manage() {
 	ensure(!network);
-	PipeNetwork::rebuild = true;
+	if (PipeNetwork::rebuild) return;
+
+	if (underground && !partner) {
+		pair();
+	}
+
+	PipeNetwork::join(*this);
 }
 
 void Pipe::unmanage() {
-	ensure(network);
-	network->pipes.erase(id);
+	if (partner) {
+		Pipe& other = get(partner);
+		other.partner = 0;
+		partner = 0;
+		PipeNetwork::orphans.insert(other.id);
+	}
+
+	// not yet (re)flooded
+	if (!network) return;
+
+	PipeNetwork* old = network;
+	old->pipes.erase(id);
 	network = NULL;
-	PipeNetwork::rebuild = true;
+	PipeNetwork::dissolve(old);
+}
+
+// Link with the nearest unpartnered underground pipe facing back at us
+void Pipe::pair() {
+	Entity& en = Entity::get(id);
+	float dist = 0.0f;
+
+	for (uint pid: Entity::intersecting(undergroundRange())) {
+		if (id == pid) continue;
+		if (!Pipe::all.has(pid)) continue;
+		Entity& eo = Entity::get(pid);
+		if (eo.isGhost()) continue;
+		Pipe& other = Pipe::get(pid);
+		if (!other.underground) continue;
+		if (other.partner) continue;
+		if (en.dir != eo.dir.oppositeCardinal()) continue;
+		float d = en.pos.distance(eo.pos);
+		if (!partner || d < dist) {
+			partner = pid;
+			dist = d;
+		}
+	}
+
+	if (partner) {
+		Pipe::get(partner).partner = id;
+	}
+}
+
+// Adjacent non-ghost pipes with a matching connection point, plus any
+// underground partner
+std::vector<uint> Pipe::connected() {
+	std::vector<uint> hits;
+
+	for (Point p: pipeConnections()) {
+		Box box = p.box().grow(0.1f);
+		for (uint oid: Entity::intersecting(box)) {
+			if (oid == id) continue;
+
+			Entity& sen = Entity::get(oid);
+			if (sen.isGhost()) continue;
+			if (!sen.spec->pipe) continue;
+
+			Pipe& other = Pipe::get(oid);
+
+			for (Point op: other.pipeConnections()) {
+				if (box.intersects(op.box().grow(0.1f))) {
+					hits.push_back(oid);
+					break;
+				}
+			}
+		}
+	}
+
+	if (partner) {
+		hits.push_back(partner);
+	}
+
+	deduplicate(hits);
+	return hits;
 }
 
 std::vector<Point> Pipe::pipeConnections() {
@@ -70,6 +145,91 @@ void PipeNetwork::reset() {
 	while (all.size()) {
 		delete *(all.begin());
 	}
+	orphans.clear();
+	rebuild = true;
+}
+
+// Merge the networks around a newly managed pipe into the largest one.
+// Fluid follows the rebuild rule: the network holding the lowest pipe id
+// with fluid decides the type, and only matching fluid is kept.
+void PipeNetwork::join(Pipe& pipe) {
+	std::vector<PipeNetwork*> networks;
+	bool waiting = false;
+	for (uint oid: pipe.connected()) {
+		Pipe& other = Pipe::get(oid);
+		if (other.network) networks.push_back(other.network);
+		if (!other.network) waiting = true;
+	}
+	deduplicate(networks);
+
+	// a neighbour is already waiting to be re-flooded; join it there
+	if (waiting) {
+		for (auto network: networks) {
+			dissolve(network);
+		}
+		orphans.insert(pipe.id);
+		return;
+	}
+
+	if (!networks.size()) {
+		pipe.network = new PipeNetwork();
+		pipe.network->pipes.insert(pipe.id);
+		pipe.network->settle();
+		return;
+	}
+
+	PipeNetwork* survivor = networks.front();
+	PipeNetwork* fluid = nullptr;
+	for (auto network: networks) {
+		if (network->pipes.size() > survivor->pipes.size()) {
+			survivor = network;
+		}
+		if (network->fid && (!fluid || *network->pipes.begin() < *fluid->pipes.begin())) {
+			fluid = network;
+		}
+	}
+
+	uint fid = fluid ? fluid->fid: 0;
+	int tally = 0;
+	for (auto network: networks) {
+		if (fid && network->fid == fid) {
+			tally += network->tally;
+		}
+	}
+
+	for (auto network: networks) {
+		if (network == survivor) continue;
+		for (uint id: network->pipes) {
+			Pipe::get(id).network = survivor;
+			survivor->pipes.insert(id);
+		}
+		survivor->limit += network->limit;
+		network->pipes.clear();
+		delete network;
+	}
+
+	Entity& en = Entity::get(pipe.id);
+	pipe.network = survivor;
+	survivor->pipes.insert(pipe.id);
+	survivor->limit += en.spec->pipeCapacity;
+
+	if (fid && pipe.cacheFid == fid) {
+		tally += pipe.cacheTally;
+	}
+	pipe.cacheFid = fid;
+	pipe.cacheTally = 0;
+
+	survivor->fid = tally ? fid: 0;
+	survivor->tally = std::min(tally, (int)survivor->limit.value);
+}
+
+// Drop a network, caching each pipe's share of the fluid so the re-flooded
+// networks can reclaim it
+void PipeNetwork::dissolve(PipeNetwork* network) {
+	for (uint id: network->pipes) {
+		orphans.insert(id);
+	}
+	delete network;
 }
 
 void PipeNetwork::tick() {
@@ -79,144 +239,111 @@ void PipeNetwork::tick() {
 			delete *(all.begin());
 		}
 
+		orphans.clear();
+
 		for (auto& pipe: Pipe::all) {
 			ensure(!pipe.network);
+			if (pipe.underground) pipe.partner = 0;
+			if (!Entity::get(pipe.id).isGhost()) orphans.insert(pipe.id);
 		}
 
-		for (auto& pipe: Pipe::all) {
-			if (!pipe.underground) continue;
-			pipe.partner = 0;
-		}
+		rebuild = false;
+	}
 
-		for (auto& pipe: Pipe::all) {
-			if (!pipe.underground) continue;
-			Entity& en = Entity::get(pipe.id);
-			if (en.isGhost()) continue;
-
-			float dist = 0.0f;
-
-			for (uint pid: Entity::intersecting(pipe.undergroundRange())) {
-				if (pipe.id == pid) continue;
-				if (!Pipe::all.has(pid)) continue;
-				Entity& eo = Entity::get(pid);
-				if (eo.isGhost()) continue;
-				Pipe& other = Pipe::get(pid);
-				if (!other.underground) continue;
-				if (other.partner) continue;
-				if (en.dir != eo.dir.oppositeCardinal()) continue;
-				float d = en.pos.distance(eo.pos);
-				if (!pipe.partner || d < dist) {
-					pipe.partner = pid;
-					dist = d;
-				}
-			}
+	if (!orphans.size()) return;
 
-			if (pipe.partner) {
-				Pipe::get(pipe.partner).partner = pipe.id;
+	std::vector<uint> pending = {orphans.begin(), orphans.end()};
+
+	for (uint id: pending) {
+		if (!Pipe::all.has(id)) continue;
+		if (Entity::get(id).isGhost()) continue;
+		Pipe& pipe = Pipe::get(id);
+		if (!pipe.underground || pipe.partner) continue;
+
+		pipe.pair();
+
+		// a new partner may bridge to an intact network
+		if (pipe.partner) {
+			Pipe& other = Pipe::get(pipe.partner);
+			if (other.network && other.network != pipe.network) {
+				dissolve(other.network);
 			}
 		}
+	}
 
-		std::function<void(uint)> flood = [&](uint pid) {
-			Entity& en = Entity::get(pid);
-			if (en.isGhost()) return;
-
-			Pipe& pipe = Pipe::get(pid);
-
-			for (Point p: pipe.pipeConnections()) {
-				Box box = p.box().grow(0.1f);
-				for (uint oid: Entity::intersecting(box)) {
-					if (oid == pipe.id) continue;
-
-					Entity& sen = Entity::get(oid);
-					if (sen.isGhost()) continue;
-					if (!sen.spec->pipe) continue;
-
-					Pipe& other = Pipe::get(oid);
-					bool join = false;
-
-					for (Point op: other.pipeConnections()) {
-						if (box.intersects(op.box().grow(0.1f))) {
-							join = true;
-							break;
-						}
-					}
-
-					if (join) {
-						//ensure(!other.network || other.network == pipe.network);
-						if (!other.network) {
-							other.network = pipe.network;
-							pipe.network->pipes.insert(other.id);
-							flood(other.id);
-						}
-					}
-				}
-			}
+	pending = {orphans.begin(), orphans.end()};
+	orphans.clear();
 
-			if (pipe.partner) {
-				Pipe& other = Pipe::get(pipe.partner);
-				//ensure(!other.network || other.network == pipe.network);
-				if (!other.network) {
-					other.network = pipe.network;
-					other.network->pipes.insert(other.id);
-					flood(pipe.partner);
-				}
-			}
-		};
+	std::vector<PipeNetwork*> fresh;
 
-		for (auto& pipe: Pipe::all) {
-			Entity& en = Entity::get(pipe.id);
-			if (en.isGhost()) continue;
+	auto spawn = [&](bool cached) {
+		for (uint id: pending) {
+			if (!Pipe::all.has(id)) continue;
+			if (Entity::get(id).isGhost()) continue;
+			Pipe& pipe = Pipe::get(id);
+			if (pipe.network) continue;
+			if (cached && !pipe.cacheFid) continue;
 
-			if (pipe.cacheFid && !pipe.network) {
-				pipe.network = new PipeNetwork();
-				pipe.network->pipes.insert(pipe.id);
-				flood(pipe.id);
-			}
+			pipe.network = new PipeNetwork();
+			pipe.network->pipes.insert(pipe.id);
+			pipe.network->flood(pipe.id);
+			fresh.push_back(pipe.network);
 		}
+	};
 
-		for (auto& pipe: Pipe::all) {
-			Entity& en = Entity::get(pipe.id);
-			if (en.isGhost()) continue;
+	spawn(true);
+	spawn(false);
 
-			if (!pipe.network) {
-				pipe.network = new PipeNetwork();
-				pipe.network->pipes.insert(pipe.id);
-				flood(pipe.id);
-			}
-		}
+	for (auto network: fresh) {
+		network->settle();
+	}
+}
 
-		for (auto network: all) {
-			for (uint id: network->pipes) {
-				Pipe& pipe = Pipe::get(id);
-				if (pipe.cacheFid) {
-					network->fid = pipe.cacheFid;
-					//network->tally = pipe.cacheTally;
-					break;
-				}
+// Claim every pipe reachable from pid. Iterative, so network size is not
+// limited by stack depth.
+void PipeNetwork::flood(uint pid) {
+	std::vector<uint> stack = {pid};
+
+	while (stack.size()) {
+		Pipe& pipe = Pipe::get(stack.back());
+		stack.pop_back();
+
+		for (uint oid: pipe.connected()) {
+			Pipe& other = Pipe::get(oid);
+			if (!other.network) {
+				other.network = this;
+				pipes.insert(other.id);
+				stack.push_back(other.id);
 			}
 		}
+	}
+}
 
-		for (auto network: all) {
-			for (uint id: network->pipes) {
-				Entity& en = Entity::get(id);
-				Pipe& pipe = Pipe::get(id);
-				network->limit += en.spec->pipeCapacity;
-				if (pipe.cacheFid == network->fid) {
-					network->tally += pipe.cacheTally;
-				}
-				pipe.cacheFid = network->fid;
-				pipe.cacheTally = 0;
-			}
-			if (!network->tally) {
-				network->fid = 0;
-			}
-			if (network->tally > network->limit.value) {
-				network->tally = network->limit.value;
-			}
+// Derive fluid type, capacity and tally from the pipes' cached state
+void PipeNetwork::settle() {
+	for (uint id: pipes) {
+		Pipe& pipe = Pipe::get(id);
+		if (pipe.cacheFid) {
+			fid = pipe.cacheFid;
+			break;
 		}
+	}
 
-
-		rebuild = false;
+	for (uint id: pipes) {
+		Entity& en = Entity::get(id);
+		Pipe& pipe = Pipe::get(id);
+		limit += en.spec->pipeCapacity;
+		if (pipe.cacheFid == fid) {
+			tally += pipe.cacheTally;
+		}
+		pipe.cacheFid = fid;
+		pipe.cacheTally = 0;
+	}
+	if (!tally) {
+		fid = 0;
+	}
+	if (tally > limit.value) {
+		tally = limit.value;
 	}
 }
 
@@ -265,8 +392,12 @@ void PipeNetwork::cacheState() {
 	for (uint id: pipes) {
 		Entity& en = Entity::get(id);
 		Pipe& pipe = Pipe::get(id);
+		int tally = fid ? (uint)std::ceil((float)en.spec->pipeCapacity.fluids(fid) * fill): 0;
+		if (pipe.cacheFid != fid || pipe.cacheTally != tally) {
+			en.changed(Save::Section::Pipes);
+		}
 		pipe.cacheFid = fid;
-		pipe.cacheTally = fid ? (uint)std::ceil((float)en.spec->pipeCapacity.fluids(fid) * fill): 0;
+		pipe.cacheTally = tally;
 	}
 }
 
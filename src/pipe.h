@@ -37,17 +37,26 @@ struct Pipe {
 	void destroy();
 	void manage();
 	void unmanage();
+	void pair();
+	std::vector<uint> connected();
 	std::vector<Point> pipeConnections();
 	Amount contents();
 	Box undergroundRange();
 	void flush();
 };
 
+// Networks are maintained incrementally. A new pipe unions its neighbours'
+// networks into the largest one. Removing a pipe dissolves only its own
+// network, whose pipes become orphans that tick() re-floods. A full rebuild
+// is only needed after loading.
 struct PipeNetwork {
 	static void reset();
 	static void tick();
 	static inline bool rebuild = true;
 	static inline std::set<PipeNetwork*> all;
+	static inline std::set<uint> orphans;
+	static void join(Pipe& pipe);
+	static void dissolve(PipeNetwork* network);
 
 	std::set<uint> pipes;
 	uint fid;
@@ -57,6 +66,8 @@ struct PipeNetwork {
 	PipeNetwork();
 	~PipeNetwork();
 	void propagateLevels();
+	void flood(uint pid);
+	void settle();
 
 	void cacheState();
 	Amount inject(Amount amount);
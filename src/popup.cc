@@ -315,6 +315,9 @@ void EntityPopup2::draw() {
 		}
 
 		Entity &en = Entity::get(eid);
+		// the tabs below edit components directly, so save it and rouse
+		// anything asleep on it
+		en.changed().wake();
 
 		if (opened && en.spec->named) {
 			std::snprintf(name, sizeof(name), "%s", en.name().c_str());
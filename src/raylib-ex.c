@@ -22,6 +22,16 @@
 #include "../raylib/src/core.c"
 #undef RLGL_IMPLEMENTATION
 
+// Headless tools like the benchmark have no window and no GL context. Meshes
+// are still generated CPU-side but never uploaded.
+bool rlHeadless = false;
+
+static void rlLoadMeshUnlessHeadless(Mesh *mesh, bool dynamic) {
+	if (!rlHeadless) rlLoadMesh(mesh, dynamic);
+}
+
+#define rlLoadMesh rlLoadMeshUnlessHeadless
+
 #include "../raylib/src/shapes.c"
 #include "../raylib/src/models.c"
 #include "../raylib/src/textures.c"
@@ -15,6 +15,7 @@
 #include "../raylib/examples/shaders/rlights.h"
 
 extern "C" {
+	extern bool rlHeadless;
 	Color GetColorSRGB(unsigned int hexValue);
 	void* rlWindowHandle();
 	void rlDrawMeshInstanced2(Mesh mesh, Material material, int count, Matrix *transforms);
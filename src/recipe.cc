@@ -35,13 +35,15 @@ Recipe::~Recipe() {
 }
 
 Recipe* Recipe::byName(std::string name) {
-	ensuref(names.count(name) == 1, "unknown recipe %s", name.c_str());
-	return names[name];
+	auto it = names.find(name);
+	ensuref(it != names.end(), "unknown recipe %s", name.c_str());
+	return it->second;
 }
 
 Recipe* Recipe::get(uint id) {
-	ensuref(ids.count(id) == 1, "unknown recipe %d", id);
-	return ids[id];
+	auto it = ids.find(id);
+	ensuref(it != ids.end(), "unknown recipe %d", id);
+	return it->second;
 }
 
 float Recipe::rate(Spec* spec) {
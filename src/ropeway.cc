@@ -1,6 +1,7 @@
 #include "common.h"
 #include "sim.h"
 #include "ropeway.h"
+#include "jobs.h"
 
 void Ropeway::reset() {
 	all.clear();
@@ -37,18 +38,24 @@ Ropeway& Ropeway::get(uint id) {
 	return all.refer(id);
 }
 
+Ropeway& Ropeway::get(slabhandle<uint>& id) {
+	return all.refer(id);
+}
+
 void Ropeway::destroy() {
 	if (prev) disconnect(prev);
 	if (next) disconnect(next);
 	all.erase(id);
 }
 
+// By bare key, not the cached handles: RopewayBucket::plan() walks the
+// line from several threads at once, and get(slabhandle&) writes the cache.
 uint Ropeway::leader() {
-	return next ? get(next).leader(): id;
+	return next ? get((uint)next).leader(): id;
 }
 
 uint Ropeway::deputy() {
-	return prev ? get(prev).deputy(): id;
+	return prev ? get((uint)prev).deputy(): id;
 }
 
 bool Ropeway::complete() {
@@ -199,6 +206,8 @@ void Ropeway::connect(uint tid) {
 	if (other.complete()) return;
 	other.next = id;
 	prev = other.id;
+	Entity::get(id).changed(Save::Section::Ropeways);
+	Entity::get(tid).changed(Save::Section::Ropeways);
 
 	get(leader()).check = true;
 }
@@ -213,6 +222,8 @@ void Ropeway::disconnect(uint tid) {
 		other.prev = 0;
 		next = 0;
 	}
+	Entity::get(id).changed(Save::Section::Ropeways);
+	Entity::get(tid).changed(Save::Section::Ropeways);
 
 	get(leader()).check = true;
 }
@@ -268,6 +279,7 @@ void Ropeway::update() {
 
 	uint gap = 30*30;
 	bool newBucket = cycle == 0;
+	Entity::get(id).changed(Save::Section::Ropeways);
 
 	cycle++;
 	if (cycle == gap) cycle = 0;
@@ -367,8 +379,18 @@ void RopewayBucket::reset() {
 }
 
 void RopewayBucket::tick() {
+	static std::vector<RopewayBucket*> buckets;
+	buckets.clear();
 	for (auto& bucket: all) {
-		bucket.update();
+		buckets.push_back(&bucket);
+	}
+
+	Jobs::parallel(buckets.size(), 256, [&](uint begin, uint end) {
+		for (uint i = begin; i < end; i++) buckets[i]->plan();
+	});
+
+	for (auto bucket: buckets) {
+		bucket->update();
 	}
 }
 
@@ -377,6 +399,8 @@ RopewayBucket& RopewayBucket::create(uint id) {
 	bucket.id = id;
 	bucket.rid = 0;
 	bucket.step = 0;
+	bucket.orphaned = false;
+	bucket.moving = false;
 	return bucket;
 }
 
@@ -388,21 +412,42 @@ void RopewayBucket::destroy() {
 	if (Ropeway::all.count(rid)) {
 		auto& ropeway = Ropeway::get(rid);
 		ropeway.buckets.remove(id);
+		Entity::get(rid).changed(Save::Section::Ropeways);
 	}
 	all.erase(id);
 }
 
-void RopewayBucket::update() {
+// Parallel phase: advance along the ropeway
+void RopewayBucket::plan() {
+	orphaned = false;
+	moving = false;
+
 	if (!rid || !Entity::exists(rid)) {
-		Entity::get(id).remove();
+		orphaned = true;
 		return;
 	}
 
-	auto& en = Entity::get(id);
 	auto& ropeway = Ropeway::get(rid);
 
 	if (!ropeway.enabled()) return;
 
 	step = std::min((uint)(ropeway.steps.size()-1), step+1);
-	en.move(ropeway.steps[step] + (Point::Down*2.0f));
+	moving = true;
+}
+
+// Serial phase: move the entity
+void RopewayBucket::update() {
+	if (orphaned) {
+		orphaned = false;
+		Entity::get(id).remove();
+		return;
+	}
+
+	if (moving) {
+		moving = false;
+		auto& en = Entity::get(id);
+		auto& ropeway = Ropeway::get(rid);
+		en.move(ropeway.steps[step] + (Point::Down*2.0f));
+		en.changed(Save::Section::RopewayBuckets);
+	}
 }
\ No newline at end of file
@@ -25,9 +25,10 @@ struct Ropeway {
 	static inline slabmap<Ropeway,&Ropeway::id> all;
 	static Ropeway& create(uint id);
 	static Ropeway& get(uint id);
+	static Ropeway& get(slabhandle<uint>& id);
 
-	uint prev;
-	uint next;
+	slabhandle<uint> prev;
+	slabhandle<uint> next;
 	uint cycle;
 	bool check;
 	Point aim;
@@ -74,6 +75,11 @@ struct RopewayBucket {
 	uint rid;
 	uint step;
 
+	// per-tick plan, see Sim::update
+	bool orphaned;
+	bool moving;
+
 	void destroy();
+	void plan();
 	void update();
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+// Save format benchmark. Loads a save, writes it back out as JSON and as
+// binary, then loads each copy, reporting save/load times, on-disk size and
+// the entity count each load ended up with. Every step runs in a fresh
+// child process so loads never see state left over from another. Binary
+// loads spread chunk terrain and component sections over --threads workers.
+//
+//   ./factropy-savebench [--threads N] [--out dir] [save]
+
+#include "common.h"
+#include "mod.h"
+#include "sim.h"
+#include "entity.h"
+#include "scenario.h"
+#include "save.h"
+#include "jobs.h"
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+
+struct Result {
+	double saveMs = 0;
+	double loadMs = 0;
+	uint64_t entities = 0;
+};
+
+typedef std::function<Result(void)> stepCallback;
+
+static uint threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+static Result step(stepCallback fn) {
+	int fds[2];
+	ensure(pipe(fds) == 0);
+
+	pid_t child = fork();
+	ensure(child >= 0);
+
+	if (!child) {
+		close(fds[0]);
+		// workers started after fork(), which only copies the calling thread
+		Jobs::start(threads);
+		Mod* mod = new ModDuktape("base");
+		mod->load();
+		scenario();
+		Result result = fn();
+		ensure(write(fds[1], &result, sizeof(result)) == (ssize_t)sizeof(result));
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	Result result;
+	ssize_t got = read(fds[0], &result, sizeof(result));
+	close(fds[0]);
+
+	int status = 0;
+	waitpid(child, &status, 0);
+	if (got != (ssize_t)sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+		fatalf("benchmark step failed");
+	}
+	return result;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static uint64_t bytes(const std::string& dir) {
+	uint64_t sum = 0;
+	for (auto& file: std::filesystem::directory_iterator(dir)) {
+		sum += file.file_size();
+	}
+	return sum;
+}
+
+int main(int argc, char const *argv[]) {
+	std::string save = "autosave";
+	std::string out = "savebench";
+
+	for (int i = 1; i < argc; i++) {
+		auto arg = std::string(argv[i]);
+
+		if (arg == "--threads" && i+1 < argc) {
+			threads = std::max(0, std::atoi(argv[++i]));
+			continue;
+		}
+
+		if (arg == "--out" && i+1 < argc) {
+			out = argv[++i];
+			continue;
+		}
+
+		if (arg.size() && arg[0] != '-') {
+			save = arg;
+			continue;
+		}
+
+		fatalf("unexpected argument: %s", arg.c_str());
+	}
+
+	if (!std::filesystem::exists(save)) {
+		fatalf("save not found: %s", save.c_str());
+	}
+
+	rlHeadless = true;
+
+	struct Format {
+		const char* name;
+		Save::Format format;
+		std::string dir;
+		Result result;
+	};
+
+	std::vector<Format> formats = {
+		{ "json", Save::Format::Json, out + "-json" },
+		{ "binary", Save::Format::Binary, out + "-binary" },
+	};
+
+	// one load of the original, then a save in each format from that world
+	for (auto& format: formats) {
+		Result saved = step([&]() {
+			Result result;
+			Sim::load(save.c_str());
+			Save::format = format.format;
+			auto start = std::chrono::steady_clock::now();
+			Sim::save(format.dir.c_str());
+			result.saveMs = since(start);
+			result.entities = Entity::all.size();
+			return result;
+		});
+		format.result.saveMs = saved.saveMs;
+	}
+
+	for (auto& format: formats) {
+		Result loaded = step([&]() {
+			Result result;
+			auto start = std::chrono::steady_clock::now();
+			Sim::load(format.dir.c_str());
+			result.loadMs = since(start);
+			result.entities = Entity::all.size();
+			return result;
+		});
+		format.result.loadMs = loaded.loadMs;
+		format.result.entities = loaded.entities;
+	}
+
+	std::cout << "format,save_ms,load_ms,bytes,entities\n";
+	for (auto& format: formats) {
+		std::cout << fmt("%s,%0.1f,%0.1f,%lu,%lu\n",
+			format.name, format.result.saveMs, format.result.loadMs, bytes(format.dir), format.result.entities
+		);
+	}
+
+	if (formats[0].result.entities != formats[1].result.entities) {
+		notef("FAIL: formats loaded different entity counts");
+		return 1;
+	}
+
+	return 0;
+}
@@ -3,6 +3,9 @@
 #include "tech.h"
 #include "ledger.h"
 #include "entity.h"
+#include "save.h"
+#include "lz.h"
+#include "jobs.h"
 
 #include "json.hpp"
 #include <fstream>
@@ -11,7 +14,83 @@ using json = nlohmann::json;
 #include <filesystem>
 namespace fs = std::filesystem;
 
+#include <thread>
+#include <random>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace Save {
+	// The save whose world.bin plus journal.bin matches the world apart from
+	// the dirty marks, so snapshots of it can be journal batches; empty when
+	// there isn't one. Only touched on the thread holding the Sim lock.
+	static std::string synced;
+	static uint batches = 0;
+	static size_t journalBytes = 0;
+	static size_t checkpointBytes = 0;
+	// in the Sim record of a checkpoint and of every batch in its journal
+	static uint64_t checkpoint = 0;
+	// a background write failed, so the next snapshot must be a checkpoint
+	static std::atomic<bool> broken = false;
+	// Entity::sequence and laps as of the last save, to tell which ids
+	// were handed out since
+	static uint savedSequence = 0;
+	static uint64_t savedLaps = 0;
+
+	static uint64_t fresh() {
+		std::random_device rd;
+		return ((uint64_t)rd() << 32) | rd();
+	}
+
+	// Forget the dirty marks once the world matches a save on disk. Chunks
+	// clear their own flag as they are written.
+	static void clean() {
+		std::fill(Entity::dense.dirty.begin(), Entity::dense.dirty.end(), 0);
+		for (auto& [_,belt]: Conveyor::belts) {
+			belt.unsaved = false;
+		}
+		removed.clear();
+		savedSequence = Entity::sequence;
+		savedLaps = Entity::laps;
+	}
+
+	// Whether id was handed out by Entity::next() since the last save, and
+	// so isn't in it. Once the sequence laps the saved value, it can't tell.
+	static bool unsaved(uint id) {
+		uint now = Entity::sequence;
+		if (Entity::laps == savedLaps) {
+			return id > savedSequence && id <= now;
+		}
+		if (Entity::laps == savedLaps+1 && now < savedSequence) {
+			return id > savedSequence || id <= now;
+		}
+		return false;
+	}
+
+	// Only a live journal needs removals, and only of entities the save
+	// on disk holds; the rest would pile up between F5 saves for nothing.
+	void destroyed(uint id) {
+		if (synced.empty() || unsaved(id)) return;
+		removed.push_back(id);
+	}
+
+	static void synchronized(const std::string& name, size_t journal, uint count, size_t bytes) {
+		synced = name;
+		journalBytes = journal;
+		batches = count;
+		checkpointBytes = bytes;
+	}
+
+	// For saves that hold every tile: whether a loaded tile still matches
+	// what Chunk::generate made, so later saves can skip it.
+	static bool pristine(Chunk* chunk, int tx, int ty) {
+		Chunk::Tile* tile = &chunk->tiles[ty][tx];
+		Chunk::Tile base = chunk->generateTile(tx, ty);
+		return base.elevation == tile->elevation
+			&& base.mineral.iid == tile->mineral.iid
+			&& base.mineral.size == tile->mineral.size;
+	}
+
 	json timeSeriesSave(TimeSeries* ts) {
 		json state;
 		state["secondMax"] = ts->secondMax;
@@ -46,11 +125,37 @@ namespace Save {
 }
 
 namespace Sim {
+	// Written into name.tmp and swapped in at the end, so a crash mid-save
+	// leaves the previous save intact.
 	void save(const char* name) {
-		auto path = std::string(name);
+		Save::wait();
+
+		auto dest = std::string(name);
+		auto path = dest + ".tmp";
+		auto tmp = path.c_str();
 		fs::remove_all(path);
 		fs::create_directory(path);
 
+		if (Save::format == Save::Format::Binary) {
+			Save::Writer out;
+			Save::checkpoint = Save::fresh();
+			Save::save(out);
+			out.finish();
+			Save::clean();
+			Save::synced.clear();
+			if (!out.write(path + "/world.bin")) {
+				notef("save: could not write %s/world.bin", tmp);
+				return;
+			}
+			if (Save::replace(path, dest)) {
+				Save::synchronized(dest, 0, 0, out.data.size());
+			}
+			return;
+		}
+
+		Save::clean();
+		Save::synced.clear();
+
 		auto out = std::ofstream(path + "/sim.json");
 
 		json state;
@@ -61,28 +166,28 @@ namespace Sim {
 
 		out.close();
 
-		Spec::saveAll(name);
-		Recipe::saveAll(name);
-		Tech::saveAll(name);
-		Chunk::saveAll(name);
-		Entity::saveAll(name);
-		Store::saveAll(name);
-		Arm::saveAll(name);
-		Vehicle::saveAll(name);
-		Crafter::saveAll(name);
-		Depot::saveAll(name);
-		Drone::saveAll(name);
-		Burner::saveAll(name);
-		Pipe::saveAll(name);
-		Conveyor::saveAll(name);
-		Unveyor::saveAll(name);
-		Loader::saveAll(name);
-		Computer::saveAll(name);
-		RopewayBucket::saveAll(name);
-		Ropeway::saveAll(name);
-
-		Ledger::save(name);
-		Recipe::save(name);
+		Spec::saveAll(tmp);
+		Recipe::saveAll(tmp);
+		Tech::saveAll(tmp);
+		Chunk::saveAll(tmp);
+		Entity::saveAll(tmp);
+		Store::saveAll(tmp);
+		Arm::saveAll(tmp);
+		Vehicle::saveAll(tmp);
+		Crafter::saveAll(tmp);
+		Depot::saveAll(tmp);
+		Drone::saveAll(tmp);
+		Burner::saveAll(tmp);
+		Pipe::saveAll(tmp);
+		Conveyor::saveAll(tmp);
+		Unveyor::saveAll(tmp);
+		Loader::saveAll(tmp);
+		Computer::saveAll(tmp);
+		RopewayBucket::saveAll(tmp);
+		Ropeway::saveAll(tmp);
+
+		Ledger::save(tmp);
+		Recipe::save(tmp);
 
 		{
 			auto out = std::ofstream(path + "/time-series.json");
@@ -105,10 +210,23 @@ namespace Sim {
 			out << state << "\n";
 			out.close();
 		}
+
+		Save::replace(path, dest);
 	}
 
 	void load(const char* name) {
 		auto path = std::string(name);
+
+		if (fs::exists(path + "/world.bin")) {
+			Save::Reader in;
+			ensuref(in.open(path + "/world.bin"), "load: could not read %s/world.bin", name);
+			size_t journal = in.replay(path + "/journal.bin");
+			Save::load(in);
+			Save::clean();
+			Save::synchronized(path, journal, in.batches.size(), in.data.size());
+			return;
+		}
+
 		auto in = std::ifstream(path + "/sim.json");
 
 		for (std::string line; std::getline(in, line);) {
@@ -143,6 +261,9 @@ namespace Sim {
 		Ledger::load(name);
 		Recipe::load(name);
 
+		Save::clean();
+		Save::synced.clear();
+
 //		{
 //			auto in = std::ifstream(path + "/time-series.json");
 //
@@ -272,6 +393,7 @@ void Chunk::loadAll(const char* name) {
 				tile->y = state["tiles"][ty][tx][1];
 				tile->elevation = state["tiles"][ty][tx][2];
 				tile->mineral = {(uint)(state["tiles"][ty][tx][3]), (uint)(state["tiles"][ty][tx][4])};
+				chunk->edited[ty][tx] = !Save::pristine(chunk, tx, ty);
 			}
 		}
 		chunk->generated = true;
@@ -369,13 +491,14 @@ void Entity::saveAll(const char* name) {
 
 	json state;
 	state["sequence"] = sequence;
+	state["count"] = all.size();
 	out << state << "\n";
 
 	for (Entity& en: all) {
 		json state;
 		state["id"] = en.id;
 		state["spec"] = en.spec->name;
-		state["flags"] = en.flags;
+		state["flags"] = dense.flags[en.slot];
 		state["pos"] = { en.pos.x, en.pos.y, en.pos.z };
 		state["dir"] = { en.dir.x, en.dir.y, en.dir.z };
 		state["state"] = en.state;
@@ -400,6 +523,10 @@ void Entity::loadAll(const char* name) {
 	auto state = json::parse(line);
 	sequence = state["sequence"];
 
+	if (state.contains("count")) {
+		all.reserve(state["count"]);
+	}
+
 	for (std::string line; std::getline(in, line);) {
 		auto state = json::parse(line);
 		Entity& en = create(state["id"], Spec::byName(state["spec"]));
@@ -407,7 +534,7 @@ void Entity::loadAll(const char* name) {
 
 		en.pos = (Point){state["pos"][0], state["pos"][1], state["pos"][2]};
 		en.dir = (Point){state["dir"][0], state["dir"][1], state["dir"][2]};
-		en.flags = state["flags"];
+		dense.flags[en.slot] = state["flags"];
 
 		en.state = state["state"];
 		en.health = state["health"];
@@ -750,9 +877,9 @@ void Drone::saveAll(const char* name) {
 
 		json state;
 		state["id"] = drone.id;
-		state["dep"] = drone.dep;
-		state["src"] = drone.src;
-		state["dst"] = drone.dst;
+		state["dep"] = drone.dep.key;
+		state["src"] = drone.src.key;
+		state["dst"] = drone.dst.key;
 		state["srcGhost"] = drone.srcGhost;
 		state["dstGhost"] = drone.dstGhost;
 		state["stage"] = drone.stage;
@@ -771,9 +898,9 @@ void Drone::loadAll(const char* name) {
 	for (std::string line; std::getline(in, line);) {
 		auto state = json::parse(line);
 		Drone& drone = get(state["id"]);
-		drone.dep = state["dep"];
-		drone.src = state["src"];
-		drone.dst = state["dst"];
+		drone.dep = (uint)state["dep"];
+		drone.src = (uint)state["src"];
+		drone.dst = (uint)state["dst"];
 		drone.srcGhost = state["srcGhost"];
 		drone.dstGhost = state["dstGhost"];
 		drone.stage = state["stage"];
@@ -935,6 +1062,8 @@ void Conveyor::loadAll(const char* name) {
 		conveyor.side = state["side"];
 	}
 
+	rebuild = true;
+
 	in.close();
 }
 
@@ -1044,8 +1173,8 @@ void Ropeway::saveAll(const char* name) {
 
 		json state;
 		state["id"] = ropeway.id;
-		state["prev"] = ropeway.prev;
-		state["next"] = ropeway.next;
+		state["prev"] = ropeway.prev.key;
+		state["next"] = ropeway.next.key;
 		state["cycle"] = ropeway.cycle;
 
 		int i = 0;
@@ -1076,8 +1205,8 @@ void Ropeway::loadAll(const char* name) {
 	for (std::string line; std::getline(in, line);) {
 		auto state = json::parse(line);
 		Ropeway& ropeway = get(state["id"]);
-		ropeway.prev = state["prev"];
-		ropeway.next = state["next"];
+		ropeway.prev = (uint)state["prev"];
+		ropeway.next = (uint)state["next"];
 		ropeway.cycle = state["cycle"];
 
 		for (uint bid: state["buckets"]) {
@@ -1127,3 +1256,1369 @@ void RopewayBucket::loadAll(const char* name) {
 
 	in.close();
 }
+
+// Binary format, see save.h
+
+namespace Save {
+	Writer::Writer() {
+		put(magic);
+		put(version);
+	}
+
+	void Writer::str(const std::string& s) {
+		put(intern(s));
+	}
+
+	uint32_t Writer::intern(const std::string& s) {
+		auto it = stringIds.find(s);
+		if (it == stringIds.end()) {
+			it = stringIds.insert({s, (uint32_t)strings.size()}).first;
+			strings.push_back(s);
+		}
+		return it->second;
+	}
+
+	void Writer::text(const std::string& s) {
+		put((uint32_t)s.size());
+		data.append(s);
+	}
+
+	void Writer::begin(Section section) {
+		put(section);
+		sectionAt = data.size();
+		put((uint64_t)0);
+	}
+
+	void Writer::end() {
+		uint64_t length = data.size() - sectionAt - sizeof(uint64_t);
+		std::memcpy(&data[sectionAt], &length, sizeof(length));
+	}
+
+	void Writer::record() {
+		recordAt = data.size();
+		put((uint32_t)0);
+	}
+
+	void Writer::done() {
+		uint32_t length = data.size() - recordAt - sizeof(uint32_t);
+		std::memcpy(&data[recordAt], &length, sizeof(length));
+	}
+
+	void Writer::finish() {
+		begin(Section::Strings);
+		for (auto& s: strings) {
+			record();
+			text(s);
+			done();
+		}
+		end();
+	}
+
+	// synced before returning, so a rename that follows can't expose an
+	// empty file after a power cut
+	bool Writer::write(const std::string& file) {
+		FILE* out = fopen(file.c_str(), "wb");
+		if (!out) return false;
+		bool ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+		ok = fflush(out) == 0 && ok;
+		ok = fsync(fileno(out)) == 0 && ok;
+		return fclose(out) == 0 && ok;
+	}
+
+	const std::string& Cursor::str() {
+		uint32_t i = get<uint32_t>();
+		ensuref(strings && i < strings->size(), "save: bad string index %u", i);
+		return (*strings)[i];
+	}
+
+	std::string Cursor::text() {
+		uint32_t length = get<uint32_t>();
+		ensuref(pos+length <= size, "save: truncated record");
+		std::string s(data+pos, length);
+		pos += length;
+		return s;
+	}
+
+	bool Reader::open(const std::string& file) {
+		auto in = std::ifstream(file, std::ios::binary | std::ios::ate);
+		if (!in) return false;
+
+		data.resize(in.tellg());
+		in.seekg(0);
+		in.read(data.data(), data.size());
+		if (!in) return false;
+
+		parse();
+		return true;
+	}
+
+	void Reader::parse() {
+		Cursor in = { .data = data.data(), .size = data.size() };
+
+		ensuref(in.get<uint32_t>() == magic, "load: not a save file");
+		uint32_t v = in.get<uint32_t>();
+		ensuref(v == version, "load: save version %u, expected %u", v, version);
+
+		while (in.pos < in.size) {
+			auto section = in.get<Section>();
+			auto length = in.get<uint64_t>();
+			ensuref(in.pos+length <= in.size, "load: truncated section %u", (uint)section);
+			sections[section] = {in.pos, length};
+			in.pos += length;
+		}
+
+		for (auto& record: records(Section::Strings)) {
+			strings.push_back(record.text());
+		}
+	}
+
+	std::vector<Cursor> Reader::records(Section section) {
+		auto merge = merged.find(section);
+		if (merge != merged.end()) return merge->second;
+
+		std::vector<Cursor> list;
+
+		auto it = sections.find(section);
+		if (it == sections.end()) return list;
+
+		auto [at, length] = it->second;
+
+		for (size_t pos = at; pos < at+length; ) {
+			uint32_t size;
+			ensuref(pos+sizeof(size) <= at+length, "load: truncated section %u", (uint)section);
+			std::memcpy(&size, data.data()+pos, sizeof(size));
+			pos += sizeof(size);
+			ensuref(pos+size <= at+length, "load: truncated section %u", (uint)section);
+			list.push_back({ .data = data.data()+pos, .size = size, .strings = &strings });
+			pos += size;
+		}
+
+		return list;
+	}
+
+	// the checkpoint id in a Sim record, 0 for saves from before journals
+	static uint64_t checkpointOf(Reader& in) {
+		for (auto& record: in.records(Section::Sim)) {
+			record.pos = sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint);
+			if (record.pos < record.size) return record.get<uint64_t>();
+		}
+		return 0;
+	}
+
+	size_t Reader::replay(const std::string& file) {
+		auto in = std::ifstream(file, std::ios::binary | std::ios::ate);
+		if (!in) return 0;
+
+		std::string journal(in.tellg(), 0);
+		in.seekg(0);
+		in.read(journal.data(), journal.size());
+		if (!in) return 0;
+
+		uint64_t id = checkpointOf(*this);
+		size_t pos = 0;
+
+		while (pos+sizeof(uint64_t) <= journal.size()) {
+			uint64_t length;
+			std::memcpy(&length, journal.data()+pos, sizeof(length));
+			// a crash mid-append
+			if (pos+sizeof(length)+length > journal.size()) break;
+
+			auto batch = std::make_unique<Reader>();
+			batch->data = journal.substr(pos+sizeof(length), length);
+			batch->parse();
+
+			if (checkpointOf(*batch) != id) {
+				notef("load: %s belongs to another checkpoint", file.c_str());
+				break;
+			}
+
+			batches.push_back(std::move(batch));
+			pos += sizeof(length)+length;
+		}
+
+		if (pos < journal.size()) {
+			notef("load: ignoring %lu bytes at the end of %s", journal.size()-pos, file.c_str());
+		}
+
+		merge();
+		return pos;
+	}
+
+	// Bytes at the start of a record that identify it across batches, or 0
+	// for the global sections each batch holds in full.
+	static size_t keyWidth(Section section) {
+		switch (section) {
+			case Section::Sim:
+			case Section::Specs:
+			case Section::Recipes:
+			case Section::Techs:
+			case Section::Ledger:
+			case Section::Mining:
+				return 0;
+			case Section::Chunks:
+			case Section::ChunkDeltas:
+				return sizeof(int)*2;
+			default:
+				return sizeof(uint32_t);
+		}
+	}
+
+	static uint64_t key(const Cursor& record, size_t width) {
+		ensuref(width <= record.size, "load: truncated journal record");
+		uint64_t k = 0;
+		std::memcpy(&k, record.data, width);
+		return k;
+	}
+
+	// Each batch's records replace the checkpoint's (or an earlier batch's)
+	// with the same key, or append. Cursors keep pointing into the batch they
+	// came from, with its string table.
+	void Reader::merge() {
+		std::set<Section> touched;
+		std::set<uint> gone;
+
+		for (auto& batch: batches) {
+			for (auto& [section,_]: batch->sections) {
+				touched.insert(section);
+			}
+			for (auto& record: batch->records(Section::Removed)) {
+				gone.insert(record.get<uint32_t>());
+			}
+		}
+
+		touched.erase(Section::Strings);
+		touched.erase(Section::Removed);
+
+		for (Section section: touched) {
+			size_t width = keyWidth(section);
+
+			if (!width) {
+				for (auto& batch: batches) {
+					if (batch->sections.count(section)) {
+						merged[section] = batch->records(section);
+					}
+				}
+				continue;
+			}
+
+			auto list = records(section);
+			std::unordered_map<uint64_t,size_t> index;
+			index.reserve(list.size());
+			for (size_t i = 0; i < list.size(); i++) {
+				index[key(list[i], width)] = i;
+			}
+
+			for (auto& batch: batches) {
+				for (auto& record: batch->records(section)) {
+					uint64_t k = key(record, width);
+					auto it = index.find(k);
+					if (it != index.end()) {
+						list[it->second] = record;
+						continue;
+					}
+					index[k] = list.size();
+					list.push_back(record);
+				}
+			}
+
+			merged[section] = list;
+		}
+
+		if (gone.empty()) return;
+
+		// entity ids are never reused, so a removed id goes from every section
+		for (auto& [section,_]: sections) {
+			touched.insert(section);
+		}
+
+		for (Section section: touched) {
+			if (keyWidth(section) != sizeof(uint32_t) || section == Section::Strings || section == Section::Removed) continue;
+			auto list = records(section);
+			discard_if(list, [&](const Cursor& record) {
+				return gone.count(key(record, sizeof(uint32_t)));
+			});
+			merged[section] = list;
+		}
+	}
+
+	// Set while save() writes a journal batch: the entities with dirty
+	// marks, by id. Sections then hold only those records.
+	static bool journaling = false;
+	static std::vector<std::pair<uint,uint32_t>> marked;
+
+	template <typename C, typename F>
+	static void each(C& all, Section section, F fn) {
+		if (!journaling) {
+			for (auto& c: all) fn(c);
+			return;
+		}
+		for (auto [id,bits]: marked) {
+			if ((bits & bit(section)) && all.has(id)) fn(all.refer(id));
+		}
+	}
+
+	// Pipe contents and belt items change without marks; fold them in, then
+	// collect the marks.
+	static void gather() {
+		for (auto network: PipeNetwork::all) {
+			network->cacheState();
+		}
+
+		for (auto& [_,belt]: Conveyor::belts) {
+			Conveyor::changed(&belt);
+		}
+
+		auto& dense = Entity::dense;
+		marked.clear();
+		for (uint slot = 0; slot < dense.ids.size(); slot++) {
+			if (dense.ids[slot] && dense.dirty[slot]) {
+				marked.push_back({dense.ids[slot], dense.dirty[slot]});
+			}
+		}
+		std::sort(marked.begin(), marked.end());
+	}
+
+	// Items, fluids and recipes are written by name; 0/null is ""
+
+	static void item(Writer& out, uint iid) {
+		out.str(iid ? Item::get(iid)->name: "");
+	}
+
+	static uint item(Cursor& in) {
+		auto& name = in.str();
+		return name.size() ? Item::byName(name)->id: 0;
+	}
+
+	static void point(Writer& out, Point p) {
+		out.put(p.x);
+		out.put(p.y);
+		out.put(p.z);
+	}
+
+	static Point point(Cursor& in) {
+		float x = in.get<float>();
+		float y = in.get<float>();
+		float z = in.get<float>();
+		return Point(x, y, z);
+	}
+
+	template <typename C>
+	static void ids(Writer& out, const C& c) {
+		out.put((uint32_t)c.size());
+		for (uint id: c) out.put((uint32_t)id);
+	}
+
+	template <typename C>
+	static void items(Writer& out, const C& c) {
+		out.put((uint32_t)c.size());
+		for (uint iid: c) item(out, iid);
+	}
+
+	// shared by Store and the Burner fuel store
+	static void store(Writer& out, Store& store) {
+		out.put(store.sid);
+		out.put(store.activity);
+
+		out.put((uint32_t)store.stacks.size());
+		for (Stack stack: store.stacks) {
+			item(out, stack.iid);
+			out.put(stack.size);
+		}
+
+		out.put((uint32_t)store.levels.size());
+		for (auto level: store.levels) {
+			item(out, level.iid);
+			out.put(level.lower);
+			out.put(level.upper);
+			out.put(level.promised);
+			out.put(level.reserved);
+		}
+
+		ids(out, store.drones);
+	}
+
+	static void store(Cursor& in, Store& store) {
+		store.sid = in.get<uint>();
+		store.activity = in.get<uint64_t>();
+
+		for (uint n = in.get<uint32_t>(); n; n--) {
+			uint iid = item(in);
+			uint size = in.get<uint>();
+			store.stacks.push_back({iid, size});
+		}
+
+		for (uint n = in.get<uint32_t>(); n; n--) {
+			uint iid = item(in);
+			uint lower = in.get<uint>();
+			uint upper = in.get<uint>();
+			uint promised = in.get<uint>();
+			uint reserved = in.get<uint>();
+			store.levels.push_back({
+				.iid = iid,
+				.lower = lower,
+				.upper = upper,
+				.promised = promised,
+				.reserved = reserved,
+			});
+		}
+
+		for (uint n = in.get<uint32_t>(); n; n--) {
+			store.drones.insert(in.get<uint32_t>());
+		}
+	}
+
+	static void sim(Writer& out) {
+		out.begin(Section::Sim);
+		out.record();
+		out.put(Sim::tick);
+		out.put(Sim::seed);
+		out.put(Entity::sequence);
+		out.put(checkpoint);
+		out.done();
+		out.end();
+	}
+
+	static void sim(Reader& in) {
+		for (auto& record: in.records(Section::Sim)) {
+			Sim::tick = record.get<uint64_t>();
+			Sim::reseed(record.get<int64_t>());
+			Entity::sequence = record.get<uint>();
+			checkpoint = record.pos < record.size ? record.get<uint64_t>(): 0;
+		}
+	}
+
+	static void specs(Writer& out) {
+		out.begin(Section::Specs);
+		for (auto& [_,spec]: Spec::all) {
+			out.record();
+			out.str(spec->name);
+			out.put(spec->licensed);
+			out.done();
+		}
+		out.end();
+	}
+
+	static void specs(Reader& in) {
+		for (auto& record: in.records(Section::Specs)) {
+			Spec* spec = Spec::byName(record.str());
+			spec->licensed = record.get<bool>();
+		}
+	}
+
+	static void recipes(Writer& out) {
+		out.begin(Section::Recipes);
+		for (auto& [_,recipe]: Recipe::ids) {
+			out.record();
+			out.str(recipe->name);
+			out.put(recipe->licensed);
+			out.done();
+		}
+		out.end();
+
+		out.begin(Section::Mining);
+		out.record();
+		out.put(Recipe::miningRate);
+		out.done();
+		out.end();
+	}
+
+	static void recipes(Reader& in) {
+		for (auto& record: in.records(Section::Recipes)) {
+			Recipe* recipe = Recipe::byName(record.str());
+			recipe->licensed = record.get<bool>();
+		}
+
+		for (auto& record: in.records(Section::Mining)) {
+			Recipe::miningRate = record.get<float>();
+		}
+	}
+
+	static void techs(Writer& out) {
+		out.begin(Section::Techs);
+		for (auto& [_,tech]: Tech::names) {
+			out.record();
+			out.str(tech->name);
+			out.put(tech->bought);
+			out.done();
+		}
+		out.end();
+	}
+
+	static void techs(Reader& in) {
+		for (auto& record: in.records(Section::Techs)) {
+			Tech* tech = Tech::byName(record.str());
+			tech->bought = record.get<bool>();
+		}
+	}
+
+	// Chunks are saved as differences from Chunk::generateTile: each edited
+	// tile is an entry of (tiles skipped since the last entry, mask, fields),
+	// and the entries are LZ compressed. Loading regenerates the terrain
+	// from the seed and applies them.
+
+	static const uint8_t TileElevation = 1;
+	static const uint8_t TileMineral = 2;
+
+	template <typename T>
+	static void append(std::string& buf, T v) {
+		buf.append((const char*)&v, sizeof(T));
+	}
+
+	static void chunks(Writer& out) {
+		// the generator thread adds chunks under Chunk::mutex only
+		std::vector<Chunk*> ready;
+		Chunk::mutex.lock();
+		for (auto& [_,chunk]: Chunk::all) {
+			if (chunk->ready() && (chunk->unsaved || !journaling)) ready.push_back(chunk);
+		}
+		Chunk::mutex.unlock();
+
+		std::string delta;
+
+		out.begin(Section::ChunkDeltas);
+		for (Chunk* chunk: ready) {
+			out.record();
+			out.put(chunk->x);
+			out.put(chunk->y);
+
+			out.put((uint32_t)chunk->meshMinerals.size());
+			for (auto [tx,ty]: chunk->meshMinerals) {
+				out.put((uint8_t)tx);
+				out.put((uint8_t)ty);
+			}
+
+			delta.clear();
+			uint last = 0;
+
+			for (uint i = 0; i < Chunk::size*Chunk::size; i++) {
+				int tx = i%Chunk::size;
+				int ty = i/Chunk::size;
+				if (!chunk->edited[ty][tx]) continue;
+
+				Chunk::Tile* tile = &chunk->tiles[ty][tx];
+				append(delta, (uint16_t)(i-last));
+				append(delta, (uint8_t)(TileElevation|TileMineral));
+				append(delta, tile->elevation);
+				append(delta, out.intern(tile->mineral.iid ? Item::get(tile->mineral.iid)->name: ""));
+				append(delta, tile->mineral.size);
+				last = i;
+			}
+
+			auto packed = LZ::compress(delta);
+			out.put((uint32_t)delta.size());
+			out.put((uint32_t)packed.size());
+			out.data.append(packed);
+			out.done();
+			chunk->unsaved = false;
+		}
+		out.end();
+	}
+
+	// Tiles for one ChunkDeltas record, read from just past its header.
+	// Writes only to its own chunk, so chunks can rebuild in parallel.
+	static void terrain(Cursor& record, Chunk* chunk, std::string& delta) {
+		int x = chunk->x;
+		int y = chunk->y;
+
+		for (int ty = 0; ty < Chunk::size; ty++) {
+			for (int tx = 0; tx < Chunk::size; tx++) {
+				chunk->tiles[ty][tx] = chunk->generateTile(tx, ty);
+			}
+		}
+
+		uint32_t size = record.get<uint32_t>();
+		uint32_t packed = record.get<uint32_t>();
+		ensuref(record.pos+packed <= record.size, "load: truncated chunk %d,%d", x, y);
+		ensuref(LZ::decompress(record.data+record.pos, packed, size, delta), "load: corrupt chunk %d,%d", x, y);
+		record.pos += packed;
+
+		Cursor entries = { .data = delta.data(), .size = delta.size(), .strings = record.strings };
+
+		for (uint i = 0; entries.pos < entries.size; ) {
+			i += entries.get<uint16_t>();
+			ensuref(i < Chunk::size*Chunk::size, "load: corrupt chunk %d,%d", x, y);
+
+			int tx = i%Chunk::size;
+			int ty = i/Chunk::size;
+			Chunk::Tile* tile = &chunk->tiles[ty][tx];
+
+			uint8_t mask = entries.get<uint8_t>();
+			if (mask & TileElevation) {
+				tile->elevation = entries.get<float>();
+			}
+			if (mask & TileMineral) {
+				uint iid = item(entries);
+				uint size = entries.get<uint>();
+				tile->mineral = {iid, size};
+			}
+			chunk->edited[ty][tx] = true;
+		}
+	}
+
+	static void chunks(Reader& in) {
+		std::vector<Chunk*> loaded;
+
+		// saves from before ChunkDeltas: every tile in full
+		for (auto& record: in.records(Section::Chunks)) {
+			int x = record.get<int>();
+			int y = record.get<int>();
+			Chunk *chunk = new Chunk(x, y);
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				int tx = record.get<uint8_t>();
+				int ty = record.get<uint8_t>();
+				chunk->meshMinerals.push_back({tx, ty});
+			}
+
+			for (int ty = 0; ty < Chunk::size; ty++) {
+				for (int tx = 0; tx < Chunk::size; tx++) {
+					Chunk::Tile* tile = &chunk->tiles[ty][tx];
+					tile->x = x*Chunk::size+tx;
+					tile->y = y*Chunk::size+ty;
+					tile->elevation = record.get<float>();
+					uint iid = item(record);
+					uint size = record.get<uint>();
+					tile->mineral = {iid, size};
+					chunk->edited[ty][tx] = !pristine(chunk, tx, ty);
+				}
+			}
+
+			loaded.push_back(chunk);
+		}
+
+		// Chunk's constructor registers it in Chunk::all, so serially
+		auto records = in.records(Section::ChunkDeltas);
+		std::vector<Chunk*> rebuild;
+
+		for (auto& record: records) {
+			int x = record.get<int>();
+			int y = record.get<int>();
+			Chunk *chunk = new Chunk(x, y);
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				int tx = record.get<uint8_t>();
+				int ty = record.get<uint8_t>();
+				chunk->meshMinerals.push_back({tx, ty});
+			}
+
+			rebuild.push_back(chunk);
+		}
+
+		// terrain noise dominates loading a big map
+		Jobs::parallel(records.size(), 1, [&](uint begin, uint end) {
+			std::string delta;
+			for (uint i = begin; i < end; i++) {
+				terrain(records[i], rebuild[i], delta);
+			}
+		});
+
+		loaded.insert(loaded.end(), rebuild.begin(), rebuild.end());
+
+		// Meshes are built later by the chunk generator thread. Hills can
+		// span chunk borders, so they wait until every chunk is in place.
+		for (Chunk* chunk: loaded) {
+			chunk->generated = true;
+			chunk->unsaved = false;
+			chunk->regenerate();
+		}
+
+		for (Chunk* chunk: loaded) {
+			chunk->findHills();
+		}
+	}
+
+	static void entities(Writer& out) {
+		out.begin(Section::Entities);
+		each(Entity::all, Section::Entities, [&](Entity& en) {
+			out.record();
+			out.put(en.id);
+			out.str(en.spec->name);
+			out.put(Entity::dense.flags[en.slot]);
+			point(out, en.pos);
+			point(out, en.dir);
+			out.put(en.state);
+			out.put(en.health);
+			if (en.spec->named) {
+				out.text(en.name());
+			}
+			out.done();
+		});
+		out.end();
+	}
+
+	static void entities(Reader& in) {
+		auto records = in.records(Section::Entities);
+		Entity::all.reserve(records.size());
+
+		for (auto& record: records) {
+			uint id = record.get<uint>();
+			Entity& en = Entity::create(id, Spec::byName(record.str()));
+			en.unindex();
+
+			Entity::dense.flags[en.slot] = record.get<uint32_t>();
+			en.pos = point(record);
+			en.dir = point(record);
+			en.state = record.get<uint>();
+			en.health = record.get<Health>();
+
+			// in case spec state animations changed across save or mod upgrade
+			en.state = (uint)std::max(0, std::min((int)en.state, (int)en.spec->states.size()-1));
+
+			en.index();
+
+			if (!en.isGhost()) {
+				en.ghost().destroy();
+			}
+
+			if (en.isConstruction()) {
+				en.construct();
+			}
+
+			if (en.isDeconstruction()) {
+				en.deconstruct();
+			}
+
+			if (en.spec->named) {
+				en.rename(record.text());
+			}
+
+			en.setEnabled(true);
+		}
+	}
+
+	static void stores(Writer& out) {
+		out.begin(Section::Stores);
+		each(Store::all, Section::Stores, [&](Store& s) {
+			out.record();
+			out.put(s.id);
+			store(out, s);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void stores(Reader& in) {
+		for (auto& record: in.records(Section::Stores)) {
+			store(record, Store::get(record.get<uint>()));
+		}
+	}
+
+	static void arms(Writer& out) {
+		out.begin(Section::Arms);
+		each(Arm::all, Section::Arms, [&](Arm& arm) {
+			out.record();
+			out.put(arm.id);
+			item(out, arm.iid);
+			out.put(arm.orientation);
+			out.put((uint32_t)arm.stage);
+			out.put(arm.pause);
+			items(out, arm.filter);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void arms(Reader& in) {
+		for (auto& record: in.records(Section::Arms)) {
+			Arm& arm = Arm::get(record.get<uint>());
+			arm.iid = item(record);
+			arm.orientation = record.get<float>();
+			arm.stage = (enum Arm::Stage)record.get<uint32_t>();
+			arm.pause = record.get<uint64_t>();
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				arm.filter.insert(item(record));
+			}
+		}
+	}
+
+	// Vehicle::DepartCondition types
+	static const uint8_t DepartInactivity = 1;
+	static const uint8_t DepartItem = 2;
+
+	static void vehicles(Writer& out) {
+		out.begin(Section::Vehicles);
+		each(Vehicle::all, Section::Vehicles, [&](Vehicle& vehicle) {
+			out.record();
+			out.put(vehicle.id);
+			out.put(vehicle.pause);
+			out.put(vehicle.patrol);
+			out.put(vehicle.handbrake);
+
+			out.put((uint32_t)vehicle.path.size());
+			for (Point p: vehicle.path) {
+				point(out, p);
+			}
+
+			int waypoint = -1;
+			int i = 0;
+			for (auto wp: vehicle.waypoints) {
+				if (wp == vehicle.waypoint) waypoint = i;
+				i++;
+			}
+			out.put(waypoint);
+
+			out.put((uint32_t)vehicle.waypoints.size());
+			for (auto wp: vehicle.waypoints) {
+				point(out, wp->position);
+				out.put(wp->stopId);
+
+				std::vector<Vehicle::DepartCondition*> conditions;
+				for (auto condition: wp->conditions) {
+					auto con = dynamic_cast<Vehicle::DepartItem*>(condition);
+					if (!con || con->iid) conditions.push_back(condition);
+				}
+
+				out.put((uint32_t)conditions.size());
+				for (auto condition: conditions) {
+					if_is<Vehicle::DepartInactivity>(condition, [&](Vehicle::DepartInactivity* con) {
+						out.put(DepartInactivity);
+						out.put(con->seconds);
+					});
+
+					if_is<Vehicle::DepartItem>(condition, [&](Vehicle::DepartItem* con) {
+						out.put(DepartItem);
+						item(out, con->iid);
+						out.put(con->op);
+						out.put(con->count);
+					});
+				}
+			}
+			out.done();
+		});
+		out.end();
+	}
+
+	static void vehicles(Reader& in) {
+		for (auto& record: in.records(Section::Vehicles)) {
+			Vehicle& vehicle = Vehicle::get(record.get<uint>());
+			vehicle.pause = record.get<uint64_t>();
+			vehicle.patrol = record.get<bool>();
+			vehicle.handbrake = record.get<bool>();
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				vehicle.path.push_back(point(record));
+			}
+
+			int waypoint = record.get<int>();
+
+			uint count = record.get<uint32_t>();
+			for (int i = 0; i < (int)count; i++) {
+				Point position = point(record);
+				uint stopId = record.get<uint>();
+
+				Vehicle::Waypoint* wp = stopId ? vehicle.addWaypoint(stopId): vehicle.addWaypoint(position);
+
+				for (uint n = record.get<uint32_t>(); n; n--) {
+					uint8_t type = record.get<uint8_t>();
+
+					if (type == DepartInactivity) {
+						auto con = new Vehicle::DepartInactivity();
+						con->seconds = record.get<int>();
+						wp->conditions.push_back(con);
+						continue;
+					}
+
+					ensuref(type == DepartItem, "load: vehicle %u unknown condition %u", vehicle.id, type);
+					auto con = new Vehicle::DepartItem();
+					con->iid = item(record);
+					con->op = record.get<uint>();
+					con->count = record.get<uint>();
+					wp->conditions.push_back(con);
+				}
+
+				if (i == waypoint) {
+					vehicle.waypoint = wp;
+				}
+			}
+		}
+	}
+
+	static void crafters(Writer& out) {
+		out.begin(Section::Crafters);
+		each(Crafter::all, Section::Crafters, [&](Crafter& crafter) {
+			out.record();
+			out.put(crafter.id);
+			out.put(crafter.working);
+			out.put(crafter.progress);
+			out.put(crafter.completed);
+			out.put(crafter.once);
+			out.str(crafter.recipe ? crafter.recipe->name: "");
+			out.done();
+		});
+		out.end();
+	}
+
+	static void crafters(Reader& in) {
+		for (auto& record: in.records(Section::Crafters)) {
+			Crafter& crafter = Crafter::get(record.get<uint>());
+			crafter.working = record.get<bool>();
+			crafter.progress = record.get<float>();
+			crafter.completed = record.get<uint>();
+			crafter.once = record.get<bool>();
+			auto& recipe = record.str();
+			crafter.recipe = recipe.size() ? Recipe::byName(recipe): NULL;
+		}
+	}
+
+	static void depots(Writer& out) {
+		out.begin(Section::Depots);
+		each(Depot::all, Section::Depots, [&](Depot& depot) {
+			out.record();
+			out.put(depot.id);
+			ids(out, depot.drones);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void depots(Reader& in) {
+		for (auto& record: in.records(Section::Depots)) {
+			Depot& depot = Depot::get(record.get<uint>());
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				depot.drones.insert(record.get<uint32_t>());
+			}
+		}
+	}
+
+	static void drones(Writer& out) {
+		out.begin(Section::Drones);
+		each(Drone::all, Section::Drones, [&](Drone& drone) {
+			out.record();
+			out.put(drone.id);
+			out.put(drone.dep.key);
+			out.put(drone.src.key);
+			out.put(drone.dst.key);
+			out.put(drone.srcGhost);
+			out.put(drone.dstGhost);
+			out.put((uint32_t)drone.stage);
+			item(out, drone.stack.iid);
+			out.put(drone.stack.size);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void drones(Reader& in) {
+		for (auto& record: in.records(Section::Drones)) {
+			Drone& drone = Drone::get(record.get<uint>());
+			drone.dep = record.get<uint>();
+			drone.src = record.get<uint>();
+			drone.dst = record.get<uint>();
+			drone.srcGhost = record.get<bool>();
+			drone.dstGhost = record.get<bool>();
+			drone.stage = (enum Drone::Stage)record.get<uint32_t>();
+			uint iid = item(record);
+			uint size = record.get<uint>();
+			drone.stack = {iid, size};
+		}
+	}
+
+	static void burners(Writer& out) {
+		out.begin(Section::Burners);
+		each(Burner::all, Section::Burners, [&](Burner& burner) {
+			out.record();
+			out.put(burner.id);
+			out.put(burner.energy.value);
+			out.put(burner.buffer.value);
+			store(out, burner.store);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void burners(Reader& in) {
+		for (auto& record: in.records(Section::Burners)) {
+			Burner& burner = Burner::get(record.get<uint>());
+			burner.energy.value = record.get<int>();
+			burner.buffer.value = record.get<int>();
+			store(record, burner.store);
+		}
+	}
+
+	static void pipes(Writer& out) {
+		for (auto network: PipeNetwork::all) {
+			network->cacheState();
+		}
+
+		out.begin(Section::Pipes);
+		each(Pipe::all, Section::Pipes, [&](Pipe& pipe) {
+			out.record();
+			out.put(pipe.id);
+			out.str(pipe.cacheFid ? Fluid::get(pipe.cacheFid)->name: "");
+			out.put(pipe.cacheTally);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void pipes(Reader& in) {
+		for (auto& record: in.records(Section::Pipes)) {
+			Pipe& pipe = Pipe::get(record.get<uint>());
+			auto& fluid = record.str();
+			pipe.cacheFid = fluid.size() ? Fluid::byName(fluid)->id: 0;
+			pipe.cacheTally = record.get<int>();
+		}
+
+		PipeNetwork::rebuild = true;
+	}
+
+	static void conveyors(Writer& out) {
+		out.begin(Section::Conveyors);
+		each(Conveyor::all, Section::Conveyors, [&](Conveyor& conveyor) {
+			out.record();
+			out.put(conveyor.id);
+			item(out, conveyor.iid);
+			out.put(conveyor.offset);
+			out.put(conveyor.prev);
+			out.put(conveyor.next);
+			out.put(conveyor.side);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void conveyors(Reader& in) {
+		for (auto& record: in.records(Section::Conveyors)) {
+			Conveyor& conveyor = Conveyor::get(record.get<uint>());
+			conveyor.iid = item(record);
+			conveyor.offset = record.get<uint>();
+			conveyor.prev = record.get<uint>();
+			conveyor.next = record.get<uint>();
+			conveyor.side = record.get<uint>();
+		}
+
+		Conveyor::rebuild = true;
+	}
+
+	static void unveyors(Writer& out) {
+		out.begin(Section::Unveyors);
+		each(Unveyor::all, Section::Unveyors, [&](Unveyor& unveyor) {
+			out.record();
+			out.put(unveyor.id);
+			out.put(unveyor.partner);
+			out.put((uint32_t)unveyor.items.size());
+			for (auto& it: unveyor.items) {
+				out.put(it.offset);
+				item(out, it.iid);
+			}
+			out.done();
+		});
+		out.end();
+	}
+
+	static void unveyors(Reader& in) {
+		for (auto& record: in.records(Section::Unveyors)) {
+			Unveyor& unveyor = Unveyor::get(record.get<uint>());
+			unveyor.partner = record.get<uint>();
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				uint offset = record.get<uint>();
+				uint iid = item(record);
+				unveyor.items.push_back((Unveyor::item){ .offset = offset, .iid = iid });
+			}
+		}
+	}
+
+	static void loaders(Writer& out) {
+		out.begin(Section::Loaders);
+		each(Loader::all, Section::Loaders, [&](Loader& loader) {
+			out.record();
+			out.put(loader.id);
+			out.put(loader.storeId);
+			out.put(loader.pause);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void loaders(Reader& in) {
+		for (auto& record: in.records(Section::Loaders)) {
+			Loader& loader = Loader::get(record.get<uint>());
+			loader.storeId = record.get<uint>();
+			loader.pause = record.get<uint64_t>();
+		}
+	}
+
+	static void ropewayBuckets(Writer& out) {
+		out.begin(Section::RopewayBuckets);
+		each(RopewayBucket::all, Section::RopewayBuckets, [&](RopewayBucket& bucket) {
+			out.record();
+			out.put(bucket.id);
+			out.put(bucket.rid);
+			out.put(bucket.step);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void ropewayBuckets(Reader& in) {
+		for (auto& record: in.records(Section::RopewayBuckets)) {
+			RopewayBucket& bucket = RopewayBucket::get(record.get<uint>());
+			bucket.rid = record.get<uint>();
+			bucket.step = record.get<uint>();
+		}
+	}
+
+	static void ropeways(Writer& out) {
+		out.begin(Section::Ropeways);
+		each(Ropeway::all, Section::Ropeways, [&](Ropeway& ropeway) {
+			out.record();
+			out.put(ropeway.id);
+			out.put(ropeway.prev.key);
+			out.put(ropeway.next.key);
+			out.put(ropeway.cycle);
+			ids(out, ropeway.buckets);
+			items(out, ropeway.inputFilters);
+			items(out, ropeway.outputFilters);
+			out.done();
+		});
+		out.end();
+	}
+
+	static void ropeways(Reader& in) {
+		for (auto& record: in.records(Section::Ropeways)) {
+			Ropeway& ropeway = Ropeway::get(record.get<uint>());
+			ropeway.prev = record.get<uint>();
+			ropeway.next = record.get<uint>();
+			ropeway.cycle = record.get<uint>();
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				ropeway.buckets.push_back(record.get<uint32_t>());
+			}
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				ropeway.inputFilters.insert(item(record));
+			}
+
+			for (uint n = record.get<uint32_t>(); n; n--) {
+				ropeway.outputFilters.insert(item(record));
+			}
+
+			ropeway.check = true;
+		}
+	}
+
+	// balance first, then one record per transaction
+	static void ledger(Writer& out) {
+		out.begin(Section::Ledger);
+		out.record();
+		out.put(Ledger::balance.value);
+		out.done();
+		for (auto& trx: Ledger::transactions) {
+			out.record();
+			out.put(trx.delta.value);
+			out.text(trx.desc);
+			out.done();
+		}
+		out.end();
+	}
+
+	static void ledger(Reader& in) {
+		auto records = in.records(Section::Ledger);
+		for (uint i = 0; i < records.size(); i++) {
+			if (!i) {
+				Ledger::balance.value = records[i].get<int>();
+				continue;
+			}
+			int delta = records[i].get<int>();
+			Ledger::transactions.push_back({
+				.delta = Currency(delta),
+				.desc = records[i].text(),
+			});
+		}
+	}
+
+	static void removals(Writer& out) {
+		out.begin(Section::Removed);
+		for (uint id: removed) {
+			out.record();
+			out.put((uint32_t)id);
+			out.done();
+		}
+		out.end();
+	}
+
+	void save(Writer& out) {
+		if (journaling) gather();
+		sim(out);
+		specs(out);
+		recipes(out);
+		techs(out);
+		chunks(out);
+		entities(out);
+		stores(out);
+		arms(out);
+		vehicles(out);
+		crafters(out);
+		depots(out);
+		drones(out);
+		burners(out);
+		pipes(out);
+		conveyors(out);
+		unveyors(out);
+		loaders(out);
+		ropewayBuckets(out);
+		ropeways(out);
+		ledger(out);
+		if (journaling) removals(out);
+	}
+
+	void load(Reader& in) {
+		sim(in);
+		specs(in);
+		recipes(in);
+		techs(in);
+		chunks(in);
+		entities(in);
+
+		// Once the entities exist, each of these only writes to its own
+		// component type (looking others up read-only), so the sections
+		// load concurrently. Name lookups (Item::byName, Spec::byName...)
+		// use find() for the same reason.
+		typedef void (*loader)(Reader&);
+
+		std::vector<loader> sections = {
+			stores,
+			arms,
+			vehicles,
+			crafters,
+			depots,
+			drones,
+			burners,
+			pipes,
+			conveyors,
+			unveyors,
+			loaders,
+			ropewayBuckets,
+			ropeways,
+			ledger,
+		};
+
+		Jobs::parallel(sections.size(), 1, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				sections[i](in);
+			}
+		});
+	}
+
+	// Runs on the snapshot writer thread, so filesystem errors are
+	// returned rather than thrown.
+	bool replace(const std::string& tmp, const std::string& path) {
+		std::error_code ec;
+
+		if (!fs::exists(path, ec)) {
+			if (ec) {
+				notef("save: could not check %s: %s", path.c_str(), ec.message().c_str());
+				return false;
+			}
+			fs::rename(tmp, path, ec);
+			if (ec) {
+				notef("save: could not rename %s: %s", tmp.c_str(), ec.message().c_str());
+				return false;
+			}
+			return true;
+		}
+
+		if (renameat2(AT_FDCWD, tmp.c_str(), AT_FDCWD, path.c_str(), RENAME_EXCHANGE) != 0) {
+			notef("save: could not replace %s: %s", path.c_str(), strerror(errno));
+			return false;
+		}
+
+		// the new save is in place; a leftover old copy is harmless
+		fs::remove_all(tmp, ec);
+		if (ec) notef("save: could not remove %s: %s", tmp.c_str(), ec.message().c_str());
+		return true;
+	}
+
+	// Truncating to the last whole batch first drops a torn one left by a
+	// crash, which would otherwise hide every batch appended after it.
+	static bool append(Writer* out, const std::string& file, size_t offset) {
+		int fd = open(file.c_str(), O_WRONLY | O_CREAT, 0644);
+		if (fd < 0) return false;
+
+		uint64_t length = out->data.size();
+		bool ok = ftruncate(fd, offset) == 0
+			&& pwrite(fd, &length, sizeof(length), offset) == (ssize_t)sizeof(length)
+			&& pwrite(fd, out->data.data(), length, offset+sizeof(length)) == (ssize_t)length
+			&& fsync(fd) == 0;
+
+		return close(fd) == 0 && ok;
+	}
+
+	static std::thread writer;
+	static std::atomic<bool> writing = false;
+
+	bool snapshot(const char* name) {
+		if (format != Format::Binary) {
+			Sim::save(name);
+			return true;
+		}
+
+		if (writing) return false;
+		wait();
+
+		auto start = std::chrono::steady_clock::now();
+
+		bool full = broken || synced != name || batches >= checkpointEvery || journalBytes > checkpointBytes/2;
+		broken = false;
+
+		auto out = new Writer();
+		if (full) checkpoint = fresh();
+		journaling = !full;
+		save(*out);
+		journaling = false;
+		out->finish();
+		clean();
+
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		notef("snapshot %s: %s %lu bytes, %ld ms paused", name, full ? "checkpoint": "journal", out->data.size(),
+			std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+		);
+
+		size_t offset = journalBytes;
+		if (full) {
+			synchronized(name, 0, 0, out->data.size());
+		} else {
+			synchronized(name, offset+sizeof(uint64_t)+out->data.size(), batches+1, checkpointBytes);
+		}
+
+		writing = true;
+		writer = std::thread([out, full, offset, dest = std::string(name)]() {
+			bool ok = false;
+
+			if (full) {
+				auto path = dest + ".tmp";
+				std::error_code ec;
+				fs::remove_all(path, ec);
+				if (!ec) fs::create_directory(path, ec);
+
+				if (ec) {
+					notef("save: could not prepare %s: %s", path.c_str(), ec.message().c_str());
+				} else
+				if (out->write(path + "/world.bin")) {
+					ok = replace(path, dest);
+				} else {
+					notef("save: could not write %s/world.bin", path.c_str());
+				}
+			} else {
+				ok = append(out, dest + "/journal.bin", offset);
+				if (!ok) notef("save: could not append to %s/journal.bin", dest.c_str());
+			}
+
+			if (!ok) broken = true;
+			delete out;
+			writing = false;
+		});
+
+		return true;
+	}
+
+	bool saving() {
+		return writing;
+	}
+
+	void wait() {
+		if (writer.joinable()) {
+			writer.join();
+		}
+	}
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+// Binary saves. Sim::save writes a single world.bin into the save directory;
+// the older JSON-lines files (entities.json, stores.json...) are still
+// written instead when format is Json, as a readable export for debugging.
+// Sim::load picks whichever the directory holds.
+
+// world.bin is a header (magic, version) followed by sections, each a
+// Section id, a byte length and then length-prefixed records. Records have
+// their fields in a fixed order at fixed widths, starting with the entity
+// id for components. Spec, item, recipe and tech names go into a string
+// table section once and are referenced by index. Readers skip any bytes
+// left at the end of a record, so fields can be appended to a layout
+// without breaking older saves; anything else bumps the version.
+
+// Values are written in host byte order, which is little-endian everywhere
+// factropy runs.
+
+// Autosaves are incremental. Between full checkpoints, snapshot() appends a
+// batch to journal.bin next to world.bin holding only what changed since
+// the last save: each batch is itself a complete Writer blob (header,
+// sections, string table) prefixed by its u64 length, with every record of
+// entities marked in Entity::Dense::dirty, chunks with edits, the ids of
+// removed entities, and the small global sections in full. Loading reads
+// world.bin then overlays each batch in order, record by record keyed on
+// entity id (chunk x,y for ChunkDeltas), so the section loaders never see
+// the difference. A torn batch at the end of the journal is ignored.
+
+#include "common.h"
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <map>
+#include <atomic>
+#include <memory>
+
+namespace Save {
+	// "FSAV"
+	const uint32_t magic = 0x56415346;
+	const uint32_t version = 1;
+
+	enum class Format {
+		Binary,
+		Json,
+	};
+
+	inline Format format = Format::Binary;
+
+	// Ids are part of the file format: append only, never renumber.
+	enum class Section: uint32_t {
+		Strings = 1,
+		Sim,
+		Specs,
+		Recipes,
+		Techs,
+		Chunks,
+		Entities,
+		Stores,
+		Arms,
+		Vehicles,
+		Crafters,
+		Depots,
+		Drones,
+		Burners,
+		Pipes,
+		Conveyors,
+		Unveyors,
+		Loaders,
+		RopewayBuckets,
+		Ropeways,
+		Ledger,
+		Mining,
+		ChunkDeltas,
+		Removed,
+	};
+
+	// bit for a section in Entity::Dense::dirty
+	constexpr uint32_t bit(Section section) {
+		return 1u << (uint32_t)section;
+	}
+
+	// entities destroyed since the last save, for the journal
+	inline std::vector<uint> removed;
+	void destroyed(uint id);
+
+	struct Writer {
+		std::string data;
+		std::vector<std::string> strings;
+		std::unordered_map<std::string,uint32_t> stringIds;
+		size_t sectionAt = 0;
+		size_t recordAt = 0;
+
+		Writer();
+
+		template <typename T>
+		void put(T v) {
+			static_assert(std::is_trivially_copyable<T>::value);
+			data.append((const char*)&v, sizeof(T));
+		}
+
+		// interned in the string table
+		void str(const std::string& s);
+		uint32_t intern(const std::string& s);
+		// inline, for one-off strings like entity names
+		void text(const std::string& s);
+
+		void begin(Section section);
+		void end();
+		void record();
+		void done();
+
+		// append the string table; nothing may be written after this
+		void finish();
+		bool write(const std::string& file);
+	};
+
+	// A read position inside one record or section.
+	struct Cursor {
+		const char* data = nullptr;
+		size_t pos = 0;
+		size_t size = 0;
+		const std::vector<std::string>* strings = nullptr;
+
+		template <typename T>
+		T get() {
+			static_assert(std::is_trivially_copyable<T>::value);
+			ensuref(pos+sizeof(T) <= size, "save: truncated record");
+			T v;
+			std::memcpy(&v, data+pos, sizeof(T));
+			pos += sizeof(T);
+			return v;
+		}
+
+		const std::string& str();
+		std::string text();
+	};
+
+	struct Reader {
+		std::string data;
+		std::map<Section,std::pair<size_t,size_t>> sections;
+		std::vector<std::string> strings;
+
+		// journal batches replayed over this checkpoint, and the records
+		// of each section they touched, merged
+		std::vector<std::unique_ptr<Reader>> batches;
+		std::map<Section,std::vector<Cursor>> merged;
+
+		bool open(const std::string& file);
+		void parse();
+		std::vector<Cursor> records(Section section);
+
+		// overlay the batches in a journal file; returns the bytes of it
+		// that were whole batches for this checkpoint
+		size_t replay(const std::string& file);
+		void merge();
+	};
+
+	// whole world, in Sim::save/load order
+	void save(Writer& out);
+	void load(Reader& in);
+
+	// Swap the directory tmp into place as path in one rename, then remove
+	// whatever path held before.
+	bool replace(const std::string& tmp, const std::string& path);
+
+	// Autosave without stalling the simulation. snapshot() serializes the
+	// world into memory on the calling thread, which must hold the Sim lock,
+	// then a background thread writes it out and swaps it in like
+	// Sim::save. Only one snapshot is written at a time; while one is still
+	// in flight another is refused. JSON saves can't be deferred, so with
+	// format Json this is just Sim::save.
+	// When name is the save last written or loaded, the snapshot is a
+	// journal batch appended in place; otherwise, every checkpointEvery
+	// batches, or once the journal outgrows half the checkpoint, it is a
+	// full checkpoint that starts a fresh journal.
+	bool snapshot(const char* name);
+	bool saving();
+	void wait();
+
+	// seconds between periodic autosaves, 0 for F5 only
+	inline std::atomic<uint> interval = 0;
+
+	// journal batches between full checkpoints, 0 to always checkpoint
+	inline uint checkpointEvery = 10;
+}
@@ -0,0 +1,1809 @@
+#include "common.h"
+#include "scenario.h"
+#include "sim.h"
+#include "energy.h"
+#include "chunk.h"
+#include "spec.h"
+#include "entity.h"
+#include "item.h"
+#include "fluid.h"
+#include "tech.h"
+#include "recipe.h"
+#include "ledger.h"
+#include "part.h"
+
+void scenario() {
+	Sim::reset();
+	Sim::reseed(879600773);
+	Sim::reseedThread();
+	//Sim::seed(4);
+
+	auto droplet = Thing("models/fluid.stl");
+
+	Mesh oreLD = GenMeshSphere(0.6,6,6);
+	Thing::meshes.push_back(oreLD);
+
+	Item* item;
+
+	auto thingSheet = Thing("models/sheet-hd.stl", "models/sheet-ld.stl");
+	auto thingIngot = Thing("models/ingot.stl");
+
+	auto thingContainer = Thing("models/container-hd.stl", "models/container-ld.stl");
+	auto thingFan = Thing("models/fan-hd.stl", "models/fan-ld.stl");
+	auto thingGear = Thing("models/gear-hd.stl", "models/gear-ld.stl");
+	auto thingMiner = Thing("models/miner.stl");
+	auto thingTruckChassisEngineer = Thing("models/truck-chassis-engineer.stl");
+	//auto thingTruckChassisHauler = Thing("models/truck-chassis-hauler.stl");
+	auto thingTruckWheel = Thing("models/truck-wheel.stl");
+
+	item = new Item(Item::next(), "gear-wheel");
+	item->parts = {
+		(new Part(thingGear))->paint(0x888888ff)->gloss(16)->scale(0.8,0.8,0.8),
+	};
+	item->armV = 0.38f;
+
+	auto thingBatteryTerminal = Thing("models/battery-terminal-hd.stl", "models/battery-terminal-ld.stl");
+
+	item = new Item(Item::next(), "battery");
+	item->parts = {
+		(new Part(Thing("models/battery-body-hd.stl", "models/battery-body-ld.stl")))->paint(0xcc6600ff),
+		(new Part(Thing("models/battery-cap-hd.stl", "models/battery-cap-ld.stl")))->paint(0x888888ff),
+		(new Part(thingBatteryTerminal))->paint(0x660000ff)->translate(0,0,-0.1),
+		(new Part(thingBatteryTerminal))->paint(0x004400ff)->translate(0,0,0.1),
+	};
+
+	item = new Item(Item::next(), "electric-motor");
+	item->parts = {
+		(new Part(Thing("models/electric-motor-body-hd.stl", "models/electric-motor-body-ld.stl")))->paint(0xB22222ff),
+		(new Part(Thing("models/electric-motor-foot-hd.stl", "models/electric-motor-foot-ld.stl")))->paint(0xB0C4DEff),
+		(new Part(Thing("models/electric-motor-shaft-hd.stl", "models/electric-motor-shaft-ld.stl")))->paint(0x888888ff),
+	};
+
+	Fluid* fluid = new Fluid(Fluid::next(), "water");
+	fluid->color = BLUE;
+
+	fluid = new Fluid(Fluid::next(), "steam");
+	fluid->thermal = Energy::kJ(20);
+	fluid->color = GRAY;
+
+	Tech* tech;
+	Recipe* recipe;
+
+	for (auto iid: Item::mining) {
+		Item* item = Item::get(iid);
+		Recipe* recipe = new Recipe(Recipe::next(), "mine-" + item->name);
+		recipe->energyUsage = Energy::kJ(200);
+		recipe->tags = {"mining"};
+		recipe->mine = iid;
+		recipe->parts = {
+			(new Part(thingMiner))->paint(0xb25607ff)->scale(0.1f,0.1f,0.1f),
+		};
+		for (auto part: item->parts) {
+			recipe->parts.push_back(part);
+		}
+		recipe->licensed = true;
+	}
+
+	for (uint i = 1; i < 10; i++) {
+		tech = new Tech(Tech::next(), fmt("mining-%u", i));
+		tech->tags = {"mining"};
+		tech->cost = Currency::k(i);
+		tech->miningRate = 1.0f + ((float)i * 0.1);
+		//tech->parts = {
+		//	(new Part(thingMiner))->paint(0xb25607ff)->scale(0.1f,0.1f,0.1f),
+		//};
+	}
+
+	recipe = new Recipe(Recipe::next(), "copper-smelting1");
+	recipe->energyUsage = Energy::kJ(300);
+	recipe->tags = {"smelting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-ore")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("copper-ingot")->id, 1 },
+	};
+	recipe->parts = {
+		(new Part(thingIngot))->paint(0xda8a67ff),
+	};
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "steel-smelting1");
+	recipe->energyUsage = Energy::kJ(600);
+	recipe->tags = {"smelting"};
+	recipe->inputItems = {
+		{ Item::byName("iron-ore")->id, 2 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("steel-ingot")->id, 1 },
+	};
+	recipe->parts = {
+		(new Part(thingIngot))->paint(0xB0C4DEff),
+	};
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "brick-smelting1");
+	recipe->energyUsage = Energy::kJ(300);
+	recipe->tags = {"smelting"};
+	recipe->inputItems = {
+		{ Item::byName("stone")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("brick")->id, 2 },
+	};
+	recipe->parts = Item::byName("brick")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "copper-sheet");
+	recipe->energyUsage = Energy::kJ(300);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-ingot")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("copper-sheet")->id, 2 },
+	};
+	recipe->parts = {
+		(new Part(thingSheet))->paint(0xda8a67ff),
+	};
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "steel-sheet");
+	recipe->energyUsage = Energy::kJ(300);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-ingot")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("steel-sheet")->id, 2 },
+	};
+	recipe->parts = {
+		(new Part(thingSheet))->paint(0xB0C4DEff),
+	};
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "copper-wire");
+	recipe->energyUsage = Energy::kJ(300);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-ingot")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("copper-wire")->id, 2 },
+	};
+	recipe->parts = Item::byName("copper-wire")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "circuit-board");
+	recipe->energyUsage = Energy::kJ(600);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("log")->id, 1 },
+		{ Item::byName("copper-wire")->id, 10 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("circuit-board")->id, 50 },
+	};
+	recipe->parts = Item::byName("circuit-board")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "gear-wheel");
+	recipe->energyUsage = Energy::kJ(600);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-ingot")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+	recipe->parts = Item::byName("gear-wheel")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "pipe");
+	recipe->energyUsage = Energy::kJ(600);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-ingot")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("pipe")->id, 1 },
+	};
+	recipe->parts = Item::byName("pipe")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "battery");
+	recipe->energyUsage = Energy::kJ(900);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("copper-sheet")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("battery")->id, 2 },
+	};
+	recipe->parts = Item::byName("battery")->parts;
+
+	tech = new Tech(Tech::next(), "batteries");
+	tech->tags = {"products"};
+	tech->cost = Currency::k(1);
+	tech->licenseRecipes.insert(Recipe::byName("battery"));
+
+	recipe = new Recipe(Recipe::next(), "electric-motor");
+	recipe->energyUsage = Energy::kJ(900);
+	recipe->tags = {"crafting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("circuit-board")->id, 1 },
+		{ Item::byName("gear-wheel")->id, 1 },
+	};
+	recipe->outputItems = {
+		{ Item::byName("electric-motor")->id, 1 },
+	};
+	recipe->parts = Item::byName("electric-motor")->parts;
+
+	tech = new Tech(Tech::next(), "electric-motors");
+	tech->tags = {"products"};
+	tech->cost = Currency::k(1);
+	tech->licenseRecipes.insert(Recipe::byName("electric-motor"));
+
+	Spec* spec = new Spec("provider-container");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 2, 2, 5};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(thingContainer))->paint(0xB22222ff)->gloss(16),
+	};
+	spec->store = true;
+	spec->capacity = Mass::kg(1000);
+	spec->storeSetUpper = true;
+	spec->logistic = true;
+	spec->rotate = true;
+	spec->health = 10;
+	spec->materials = {
+		{Item::byName("steel-sheet")->id, 5},
+	};
+
+	spec = new Spec("requester-container");
+	spec->collision = {0, 0, 0, 2, 2, 5};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(thingContainer))->paint(0x0044ccff)->gloss(16),
+	};
+	spec->store = true;
+	spec->capacity = Mass::kg(1000);
+	spec->logistic = true;
+	spec->storeSetLower = true;
+	spec->storeSetUpper = true;
+	spec->rotate = true;
+	spec->health = 10;
+	spec->materials = {
+		{Item::byName("copper-sheet")->id, 5},
+	};
+
+	tech = new Tech(Tech::next(), "requester-containers");
+	tech->tags = {"storage"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("requester-container"));
+
+	auto thingAssemblerPiston = Thing("models/assembler-piston-hd.stl", "models/assembler-piston-ld.stl");
+
+	spec = new Spec("assembler");
+	spec->licensed = true;
+	spec->store = true;
+	spec->capacity = Mass::kg(100);
+	spec->loadPriority = true;
+	spec->rotate = true;
+	spec->crafter = true;
+	spec->enable = true;
+	spec->crafterProgress = false;
+	spec->recipeTags = {"crafting"};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(300);
+	spec->energyDrain = Energy::kW(9);
+	spec->collision = {0, 0, 0, 6, 3, 6};
+	spec->selection = spec->collision;
+	spec->health = 10;
+	spec->pipeInputConnections = {
+		Point(3.0f, -1.0f, 1.5f).transform(Mat4::rotateY(DEG2RAD*0)),
+		Point(3.0f, -1.0f, 1.5f).transform(Mat4::rotateY(DEG2RAD*90)),
+		Point(3.0f, -1.0f, 1.5f).transform(Mat4::rotateY(DEG2RAD*180)),
+		Point(3.0f, -1.0f, 1.5f).transform(Mat4::rotateY(DEG2RAD*270)),
+	};
+	spec->pipeOutputConnections = {
+		Point(3.0f, -1.0f, -1.5f).transform(Mat4::rotateY(DEG2RAD*0)),
+		Point(3.0f, -1.0f, -1.5f).transform(Mat4::rotateY(DEG2RAD*90)),
+		Point(3.0f, -1.0f, -1.5f).transform(Mat4::rotateY(DEG2RAD*180)),
+		Point(3.0f, -1.0f, -1.5f).transform(Mat4::rotateY(DEG2RAD*270)),
+	};
+	spec->parts = {
+		(new Part(Thing("models/assembler-chassis-hd.stl", "models/assembler-chassis-ld.stl")))->paint(0x009900ff)->gloss(16),
+		(new PartSpinner(thingFan, 1))->paint(0x666666ff)->rotate(Point::East, 70)->translate(0,0.5,2.5)->gloss(16),
+		(new PartSpinner(thingFan, 1))->paint(0x666666ff)->rotate(Point::West, 70)->translate(0,0.5,-2.5)->gloss(16),
+		(new PartSpinner(thingFan, 1))->paint(0x666666ff)->rotate(Point::North, 70)->translate(2.5,0.5,0)->gloss(16),
+		(new PartSpinner(thingFan, 1))->paint(0x666666ff)->rotate(Point::South, 70)->translate(-2.5,0.5,0)->gloss(16),
+		(new Part(thingAssemblerPiston))->paint(0x666666ff)->gloss(16),
+		(new Part(thingAssemblerPiston))->paint(0x666666ff)->translate(0,0,1.2)->gloss(16),
+		(new Part(thingAssemblerPiston))->paint(0x666666ff)->translate(0,0,-1.2)->gloss(16),
+		(new Part(thingGear))->paint(0xcaccceff)->scale(1.5,1.8,1.5)->rotate(Point::East, 90)->translate(1,1,-1.2)->gloss(16),
+		(new Part(thingGear))->paint(0xcaccceff)->scale(1.1,1.8,1.1)->rotate(Point::East, 90)->translate(1,1,-0.6)->gloss(16),
+		(new Part(thingGear))->paint(0xcaccceff)->scale(1.3,1.8,1.3)->rotate(Point::East, 90)->translate(1,1, 0.0)->gloss(16),
+		(new Part(thingGear))->paint(0xcaccceff)->scale(1.2,1.8,1.2)->rotate(Point::East, 90)->translate(1,1, 0.6)->gloss(16),
+		(new Part(thingGear))->paint(0xcaccceff)->scale(1.4,1.8,1.4)->rotate(Point::East, 90)->translate(1,1, 1.2)->gloss(16),
+	};
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 5 },
+		{ Item::byName("circuit-board")->id, 3 },
+	};
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (int i = 0; i < 360; i++) {
+			Mat4 state1 = Mat4::rotateY((float)(i*5)*DEG2RAD);
+
+			Mat4 piston1 = state0;
+			Mat4 piston2 = state0;
+			Mat4 piston3 = state0;
+
+			if (i >=   0 && i <  60) piston1 = Mat4::translate(0,(float)(i%60)*-0.01f,0);
+			if (i >=  60 && i < 120) piston1 = Mat4::translate(0,(float)-0.60+(i%60)*0.01f,0);
+
+			if (i >= 120 && i < 180) piston2 = Mat4::translate(0,(float)(i%60)*-0.01f,0);
+			if (i >= 180 && i < 240) piston2 = Mat4::translate(0,(float)-0.60+(i%60)*0.01f,0);
+
+			if (i >= 240 && i < 300) piston3 = Mat4::translate(0,(float)(i%60)*-0.01f,0);
+			if (i >= 300 && i < 360) piston3 = Mat4::translate(0,(float)-0.60+(i%60)*0.01f,0);
+
+			spec->states.push_back({
+				state0,
+				state1,
+				state1,
+				state1,
+				state1,
+
+				piston1,
+				piston2,
+				piston3,
+
+				Mat4::rotateY((float)i*1.0f*DEG2RAD),
+				Mat4::rotateY((float)i*-0.8f*DEG2RAD),
+				Mat4::rotateY((float)i*0.6f*DEG2RAD),
+				Mat4::rotateY((float)i*-0.4f*DEG2RAD),
+				Mat4::rotateY((float)i*0.2f*DEG2RAD),
+			});
+		}
+	}
+
+	spec = new Spec("furnace");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 4, 4, 4};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/furnace-hd.stl", "models/furnace-ld.stl")))->paint(0xDAA520ff),
+		(new Part(Thing("models/furnace-fire-hd.stl", "models/furnace-fire-ld.stl")))->paint(0x000000ff),
+		(new Part(Thing("models/furnace-smoke-hd.stl", "models/furnace-smoke-ld.stl")))->paint(0x000000ff),
+		(new PartSmoke(2400, 20, 0.01, 0.5f, 0.01f, 0.005f, 0.1f, 0.99f, 60, 180))->translate(0,2,0),
+	};
+	spec->health = 10;
+	spec->store = true;
+	spec->capacity = Mass::kg(100);
+	spec->rotate = true;
+	spec->crafter = true;
+	spec->loadPriority = true;
+	spec->crafterProgress = true;
+	spec->recipeTags = {"smelting"};
+	spec->consumeChemical = true;
+	spec->energyConsume = Energy::kW(100);
+	spec->energyDrain = Energy::kW(3);
+	spec->materials = {
+		{ Item::byName("copper-sheet")->id, 3 },
+		{ Item::byName("brick")->id, 3 },
+	};
+
+	for (uint i = 0; i < 10; i++) {
+		float fi = (float)i;
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::scale(0.1f*fi, 0.1f*fi, 0.1f*fi),
+		});
+	}
+
+	for (uint i = 0; i < 80; i++) {
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+		});
+	}
+
+	for (uint i = 0; i < 10; i++) {
+		float fi = (float)(9-i);
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::scale(0.1f*fi, 0.1f*fi, 0.1f*fi),
+		});
+	}
+
+	spec = new Spec("miner");
+	spec->licensed = true;
+	spec->store = true;
+	spec->capacity = Mass::kg(10);
+	spec->rotate = true;
+	spec->place = Spec::Footings;
+	spec->footings = {
+		{.place = Spec::Hill, .point = Point(-2,-3,0)},
+		{.place = Spec::Hill, .point = Point(2,-3,0)},
+		{.place = Spec::Land, .point = Point(0,-3,4)},
+	};
+	spec->crafter = true;
+	spec->crafterProgress = false;
+	spec->enable = true;
+	spec->recipeTags = {"mining"};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(100);
+	spec->energyDrain = Energy::kW(3);
+	spec->collision = {0, 0, 0, 5, 5, 10};
+	spec->selection = spec->collision;
+	spec->health = 10;
+	spec->parts = {
+		(new Part(thingMiner))->paint(0xCD853Fff),
+		(new Part(thingGear))->paint(0xccccccff)->scale(3,3,3)->rotate(Point::East, 90)->translate(0,0,3.75)->gloss(16),
+	};
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 3 },
+	};
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (int i = 0; i < 180; i++) {
+			Mat4 state1 = Mat4::rotateY((float)i*DEG2RAD);
+
+			spec->states.push_back({
+				state0,
+				state1,
+			});
+		}
+	}
+
+	spec = new Spec("offshore-pump");
+	spec->licensed = true;
+	spec->rotate = true;
+	spec->place = Spec::Water;
+	spec->pipeOutputConnections = {
+		{1.5f, -1.0f, 0.0f},
+	};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(100);
+	spec->energyDrain = Energy::kW(3);
+	spec->collision = {0, 0, 0, 3, 3, 3};
+	spec->selection = spec->collision;
+	spec->crafter = true;
+	spec->enable = true;
+	spec->recipeTags = {"offshore-pumping"};
+	spec->health = 10;
+	spec->parts = {
+		(new Part(Thing("models/offshore-pump-chassis-hd.stl", "models/offshore-pump-chassis-ld.stl")))->paint(0x4444ccff)->translate(0,-1.5,0),
+		(new Part(Thing("models/offshore-pump-pipe-hd.stl", "models/offshore-pump-pipe-ld.stl")))->paint(0xccccccff)->translate(0,-1.5,0),
+	};
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 3 },
+	};
+
+	recipe = new Recipe(Recipe::next(), "offshore-pumping");
+	recipe->energyUsage = Energy::kJ(10);
+	recipe->tags = {"offshore-pumping"};
+	recipe->outputFluids = {
+		{ Fluid::byName("water")->id, 1000 },
+	};
+	recipe->licensed = true;
+
+	auto waterDroplet = new Part(droplet);
+	waterDroplet->color = Fluid::byName("water")->color;
+
+	recipe->parts = {waterDroplet};
+
+	auto beltSurface = Thing("models/belt-surface-hd.stl", "models/belt-surface-ld.stl");
+	auto beltRidge = Thing("models/belt-ridge-hd.stl", "models/belt-ridge-ld.stl");
+
+	spec = new Spec("conveyor");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = {0, -0.75, 0, 1, 0.5, 1};
+	spec->rotate = true;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::North;
+	spec->conveyorOutput = Point::South;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::South * 0.5f;
+		Point step = Point::North * (1.0f/30.0f);
+		for (int i = 0; i < 30; i++) {
+			Point p = base + (step * (float)i);
+			spec->conveyorTransforms.push_back(p.translation());
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/belt-base-hd.stl", "models/belt-base-ld.stl")))->paint(0xffff00ff)->translate(0,-1.5,0),
+			(new Part(beltSurface))->paint(0x111111ff)->translate(0,-1.5,0),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("gear-wheel")->id, 1 },
+		{ Item::byName("steel-sheet")->id, 1 },
+	};
+
+	spec = new Spec("conveyor-right");
+	spec->licensed = true;
+	spec->build = false;
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = {0, -0.75, 0, 1, 0.5, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::East;
+	spec->conveyorOutput = Point::South;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::North*0.5f;
+		Mat4 a = Mat4::translate(Point::South*0.5f + Point::East*0.5f);
+		float step = -(90.0f/30.0f)*DEG2RAD;
+		for (int i = 29; i >= 0; i--) {
+			Mat4 r = Mat4::rotateY(step * (float)i);
+			Mat4 t = Mat4::translate(base.transform(r * a));
+			Mat4 d = Mat4::rotateY(-step * (float)(29-i));
+			spec->conveyorTransforms.push_back(d * t);
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/belt-right-base-hd.stl", "models/belt-right-base-ld.stl")))
+				->paint(0xffff00ff)->scale(0.001, 0.001, 0.001)->translate(0,-1.5,0),
+			(new Part(Thing("models/belt-right-surface-hd.stl")))->paint(0x111111ff)->translate(0,-1.5,0),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("gear-wheel")->id, 1 },
+		{ Item::byName("steel-sheet")->id, 1 },
+	};
+
+	spec = new Spec("conveyor-left");
+	spec->licensed = true;
+	spec->build = false;
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = {0, -0.75, 0, 1, 0.5, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::West;
+	spec->conveyorOutput = Point::South;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::North*0.5f;
+		Mat4 a = Mat4::translate(Point::South*0.5f + Point::West*0.5f);
+		float step = (90.0f/30.0f)*DEG2RAD;
+		for (int i = 29; i >= 0; i--) {
+			Mat4 r = Mat4::rotateY(step * (float)i);
+			Mat4 t = Mat4::translate(base.transform(r * a));
+			Mat4 d = Mat4::rotateY(-step * (float)(29-i));
+			spec->conveyorTransforms.push_back(d * t);
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/belt-left-base-hd.stl")))->paint(0xffff00ff)->translate(0,-1.5,0),
+			(new Part(Thing("models/belt-left-surface-hd.stl")))->paint(0x111111ff)->translate(0,-1.5,0),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("gear-wheel")->id, 1 },
+		{ Item::byName("steel-sheet")->id, 1 },
+	};
+
+	// conveyors are modelled for output==direction, but it seems easier to visualise in-game
+	// as input==direction. So the cycle order is reversed for a clockwise rotation
+	Spec::byName("conveyor")->cycle = Spec::byName("conveyor-left");
+	Spec::byName("conveyor-left")->cycle = Spec::byName("conveyor-right");
+	Spec::byName("conveyor-right")->cycle = Spec::byName("conveyor");
+
+	Spec::byName("conveyor-right")->pipette = Spec::byName("conveyor");
+	Spec::byName("conveyor-left")->pipette = Spec::byName("conveyor");
+
+	Spec::byName("conveyor-left")->statsGroup = Spec::byName("conveyor");
+	Spec::byName("conveyor-right")->statsGroup = Spec::byName("conveyor");
+
+	spec = new Spec("unveyor-entry");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 1, 2, 2};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->unveyor = true;
+	spec->unveyorEntry = true;
+	spec->unveyorRange = 10.0f;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::North*1.5f;
+	spec->conveyorOutput = Point::Zero;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::Zero;
+		Point step = Point::North * (1.0f/30.0f);
+		for (int i = 0; i < 30; i++) {
+			Point p = base + (step * (float)i);
+			spec->conveyorTransforms.push_back(p.translation());
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/unveyor-base-hd.stl", "models/unveyor-base-ld.stl")))
+				->scale(0.001, 0.001, 0.001)->paint(0xffff00ff)->translate(0,-1.25,0),
+			(new Part(Thing("models/belt-base-hd.stl", "models/belt-base-ld.stl")))->paint(0xffff00ff)->translate(0,-1.5,-0.5),
+			(new Part(beltSurface))->paint(0x111111ff)->translate(0,-1.5,-0.5),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 2 },
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+
+	spec = new Spec("unveyor-exit");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 1, 2, 2};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->unveyor = true;
+	spec->unveyorEntry = false;
+	spec->unveyorRange = 10.0f;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::Zero;
+	spec->conveyorOutput = Point::South*1.5f;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::South;
+		Point step = Point::North * (1.0f/30.0f);
+		for (int i = 0; i < 30; i++) {
+			Point p = base + (step * (float)i);
+			spec->conveyorTransforms.push_back(p.translation());
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/unveyor-base-hd.stl", "models/unveyor-base-ld.stl")))->paint(0xffff00ff)
+				->scale(0.001, 0.001, 0.001)->rotate(Point::Up, 180)->translate(0,-1.25,0),
+			(new Part(Thing("models/belt-base-hd.stl", "models/belt-base-ld.stl")))->paint(0xffff00ff)->translate(0,-1.5,0.5),
+			(new Part(beltSurface))->paint(0x111111ff)->translate(0,-1.5,0.5),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 2 },
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+
+	Spec::byName("unveyor-entry")->cycle = Spec::byName("unveyor-exit");
+	Spec::byName("unveyor-entry")->cycleReverseDirection = true;
+	Spec::byName("unveyor-exit")->cycle = Spec::byName("unveyor-entry");
+	Spec::byName("unveyor-exit")->cycleReverseDirection = true;
+
+	Spec::byName("unveyor-exit")->statsGroup = Spec::byName("unveyor-entry");
+
+	spec = new Spec("loader");
+	spec->collision = {0, 0, 0, 1, 2, 2};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->loader = true;
+	spec->loaderUnload = false;
+	spec->loaderPoint = Point::South*1.5f;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::North*1.5f;
+	spec->conveyorOutput = Point::Zero;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::Zero;
+		Point step = Point::North * (1.0f/30.0f);
+		for (int i = 0; i < 30; i++) {
+			Point p = base + (step * (float)i);
+			spec->conveyorTransforms.push_back(p.translation());
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/loader-base-hd.stl", "models/loader-base-ld.stl")))
+				->scale(0.001, 0.001, 0.001)->paint(0xffff00ff)->translate(0,-1,0),
+			(new Part(Thing("models/belt-base-hd.stl", "models/belt-base-ld.stl")))->paint(0xffff00ff)->translate(0,-1.5,-0.5),
+			(new Part(beltSurface))->paint(0x111111ff)->translate(0,-1.5,-0.5),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+
+	spec = new Spec("unloader");
+	spec->collision = {0, 0, 0, 1, 2, 2};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->loader = true;
+	spec->loaderUnload = true;
+	spec->loaderPoint = Point::North*1.5f;
+	spec->conveyor = true;
+	spec->conveyorInput = Point::Zero;
+	spec->conveyorOutput = Point::South*1.5f;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::kW(1);
+	spec->health = 10;
+
+	{
+		Point base = Point::South;
+		Point step = Point::North * (1.0f/30.0f);
+		for (int i = 0; i < 30; i++) {
+			Point p = base + (step * (float)i);
+			spec->conveyorTransforms.push_back(p.translation());
+		}
+	}
+
+	{
+		std::vector<Mat4> ridgeTransforms(spec->conveyorTransforms.rbegin(), spec->conveyorTransforms.rend());
+		spec->parts = {
+			(new Part(Thing("models/loader-base-hd.stl", "models/loader-base-ld.stl")))->paint(0xffff00ff)
+				->scale(0.001, 0.001, 0.001)->rotate(Point::Up, 180)->translate(0,-1,0),
+			(new Part(Thing("models/belt-base-hd.stl", "models/belt-base-ld.stl")))->paint(0xffff00ff)->translate(0,-1.5,0.5),
+			(new Part(beltSurface))->paint(0x111111ff)->translate(0,-1.5,0.5),
+			(new PartCycle2(beltRidge, ridgeTransforms))->paint(0xffff00ff)->translate(0,-1.5,0)->ld(false),
+		};
+	}
+
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+
+	Spec::byName("loader")->cycle = Spec::byName("unloader");
+	Spec::byName("loader")->cycleReverseDirection = true;
+	Spec::byName("unloader")->cycle = Spec::byName("loader");
+	Spec::byName("unloader")->cycleReverseDirection = true;
+
+	Spec::byName("unloader")->statsGroup = Spec::byName("loader");
+
+	tech = new Tech(Tech::next(), "loaders");
+	tech->tags = {"logistics"};
+	tech->cost = Currency::k(5);
+	tech->licenseSpecs.insert(Spec::byName("loader"));
+	tech->licenseSpecs.insert(Spec::byName("unloader"));
+	//tech->parts = {
+	//	(new Part(thingMiner))->paint(0xb25607ff)->scale(0.1f,0.1f,0.1f),
+	//};
+
+	spec = new Spec("ropeway-terminus");
+	spec->collision = {0, 0, 0, 5, 10, 5};
+	spec->selection = spec->collision;
+	spec->enable = true;
+	spec->rotate = false;
+	spec->ropeway = true;
+	spec->ropewayTerminus = true;
+	spec->ropewayCableEast = (Point::East*1.5f) + (Point::Up*5.0f);
+	spec->store = true;
+	spec->capacity = Mass::kg(1000);
+	spec->storeSetUpper = true;
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::MW(1);
+	spec->energyDrain = Energy::kW(33);
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/cablecar-terminus-hd.stl", "models/cablecar-terminus-ld.stl")))->paint(0xffff00ff)->translate(0,-5,0),
+		(new Part(Thing("models/cablecar-mast-hd.stl", "models/cablecar-mast-ld.stl")))->paint(0xffff00ff)->translate(0,-5,0)->pivots(),
+	};
+
+	spec = new Spec("ropeway-tower");
+	spec->collision = {0, 0, 0, 3, 10, 3};
+	spec->selection = spec->collision;
+	spec->place = Spec::Land | Spec::Hill;
+	spec->placeOnHill = true;
+	spec->rotate = false;
+	spec->ropeway = true;
+	spec->ropewayTower = true;
+	spec->ropewayCableEast = (Point::East*1.5f) + (Point::Up*5.0f);
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(100);
+	spec->energyDrain = Energy::kW(3);
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/cablecar-tower-hd.stl", "models/cablecar-tower-ld.stl")))->paint(0xffff00ff)->translate(0,-5,0),
+		(new Part(Thing("models/cablecar-mast-hd.stl", "models/cablecar-mast-ld.stl")))->paint(0xffff00ff)->translate(0,-5,0)->pivots(),
+	};
+
+	spec = new Spec("ropeway-bucket");
+	spec->build = false;
+	spec->collision = {0, 0, 0, 2, 4, 2};
+	spec->selection = spec->collision;
+	spec->rotate = false;
+	spec->ropewayBucket = true;
+	spec->align = false;
+	spec->store = true;
+	spec->capacity = Mass::kg(1000);
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/cablecar-bucket-hd.stl", "models/cablecar-bucket-ld.stl")))->paint(0xffff00ff)->translate(0,-2,0),
+	};
+
+	Spec::byName("ropeway-terminus")->cycle = Spec::byName("ropeway-tower");
+	Spec::byName("ropeway-tower")->cycle = Spec::byName("ropeway-terminus");
+
+	Spec::byName("ropeway-terminus")->ropewayBucketSpec = Spec::byName("ropeway-bucket");
+
+	tech = new Tech(Tech::next(), "ropeways");
+	tech->tags = {"logistics"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("ropeway-terminus"));
+	tech->licenseSpecs.insert(Spec::byName("ropeway-tower"));
+
+	spec = new Spec("fluid-tank");
+	spec->licensed = true;
+	spec->pipe = true;
+	spec->collision = {0, 0, 0, 5, 3, 5};
+	spec->selection = spec->collision;
+	spec->pipeConnections = {Point::North*2.5f+Point::Down, Point::South*2.5f+Point::Down, Point::East*2.5f+Point::Down, Point::West*2.5f+Point::Down};
+	spec->pipeCapacity = Liquid::l(50000);
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/fluid-tank-base-hd.stl", "models/fluid-tank-base-ld.stl")))->paint(0xffa500ff)->translate(0,-1.5,0),
+	};
+
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 3 },
+	};
+
+	spec = new Spec("pipe-straight");
+	spec->licensed = true;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(100);
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->pipeConnections = {Point::North*0.5f, Point::South*0.5f};
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/pipe-straight-hd.stl", "models/pipe-straight-ld.stl")))->paint(0xffa500ff)->rotate(Point::Up, -90),
+	};
+
+	spec->materials = {
+		{ Item::byName("pipe")->id, 1 },
+	};
+
+	spec = new Spec("pipe-cross");
+	spec->licensed = true;
+	spec->build = false;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(100);
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->pipeConnections = {Point::North*0.5f, Point::South*0.5f, Point::East*0.5f, Point::West*0.5f};
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/pipe-cross-hd.stl", "models/pipe-cross-ld.stl")))->paint(0xffa500ff)->rotate(Point::Up, -90),
+	};
+
+	spec->materials = {
+		{ Item::byName("pipe")->id, 1 },
+	};
+
+	spec = new Spec("pipe-tee");
+	spec->licensed = true;
+	spec->build = false;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(100);
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->pipeConnections = {Point::South*0.5f, Point::East*0.5f, Point::West*0.5f};
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/pipe-tee-hd.stl", "models/pipe-tee-ld.stl")))->paint(0xffa500ff)->rotate(Point::Up, -90),
+	};
+
+	spec->materials = {
+		{ Item::byName("pipe")->id, 1 },
+	};
+
+	spec = new Spec("pipe-elbow");
+	spec->licensed = true;
+	spec->build = false;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(100);
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->pipeConnections = {Point::South*0.5f, Point::East*0.5f};
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/pipe-elbow-hd.stl", "models/pipe-elbow-ld.stl")))->paint(0xffa500ff)->rotate(Point::Up, -90),
+	};
+
+	spec->materials = {
+		{ Item::byName("pipe")->id, 1 },
+	};
+
+	spec = new Spec("pipe-ground");
+	spec->licensed = true;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(500);
+	spec->pipeUnderground = true;
+	spec->pipeUndergroundRange = 10.0f;
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->rotate = true;
+	spec->pipeConnections = {Point::North*0.5f};
+	spec->health = 10;
+
+	spec->parts = {
+		(new Part(Thing("models/pipe-ground-hd.stl", "models/pipe-ground-ld.stl")))->paint(0xffa500ff)->rotate(Point::Up, -90),
+	};
+
+	spec->materials = {
+		{ Item::byName("pipe")->id, 5 },
+	};
+
+	Spec::byName("pipe-straight")->cycle = Spec::byName("pipe-ground");
+	Spec::byName("pipe-ground")->cycle = Spec::byName("pipe-elbow");
+	Spec::byName("pipe-elbow")->cycle = Spec::byName("pipe-tee");
+	Spec::byName("pipe-tee")->cycle = Spec::byName("pipe-cross");
+	Spec::byName("pipe-cross")->cycle = Spec::byName("pipe-straight");
+
+	std::vector<Spec*> rocks;
+
+	for (int i = 1; i < 4; i++) {
+		auto name = "rock" + std::to_string(i);
+		auto part = "models/" + name + ".stl";
+
+		spec = new Spec(name);
+		spec->build = false;
+		spec->collision = {0, 0, 0, 2, 1, 2};
+		spec->selection = spec->collision;
+		spec->health = 100;
+		spec->pivot = true;
+		spec->junk = true;
+		spec->parts = {
+			(new Part(Thing(part)))->paint(0x888888ff),
+		};
+		spec->materials = {
+			{Item::byName("stone")->id, 1},
+		};
+
+		rocks.push_back(spec);
+	}
+
+	Chunk::generator([=](Chunk *chunk) {
+		for (int y = 0; y < Chunk::size; y++) {
+			for (int x = 0; x < Chunk::size; x++) {
+				Box bounds = {(float)chunk->x*Chunk::size+x, 0.0f, (float)chunk->y*Chunk::size+y, 2.0f, 1.0f, 2.0f};
+				if (Chunk::isLand(bounds.grow(1.0f))) {
+					double n = Sim::noise2D(chunk->x*Chunk::size+x + 1000000, chunk->y*Chunk::size+y + 1000000, 8, 0.6, 0.015);
+					if (n < 0.4 && Sim::random() < 0.04) {
+						Spec *spec = rocks[Sim::choose(rocks.size())];
+						Entity::create(Entity::next(), spec)
+							.look(Point::South.randomHorizontal())
+							.move((Point){
+								(float)(chunk->x*Chunk::size+x),
+								spec->collision.h/2.0f,
+								(float)(chunk->y*Chunk::size+y),
+							})
+							.materialize()
+						;
+					}
+				}
+			}
+		}
+	});
+
+	std::vector<Spec*> trees;
+
+	spec = new Spec("tree1");
+	spec->build = false;
+	spec->collision = {0, 0, 0, 2, 5, 2};
+	spec->selection = spec->collision;
+	spec->pivot = true;
+	spec->junk = true;
+	spec->health = 10;
+	spec->parts = {
+		(new Part(Thing("models/tree1.stl").smooth()))->paint(0x556B2Fff)->translate(0,-2.5,0),
+	};
+	spec->materials = {
+		{Item::byName("log")->id, 1},
+	};
+
+	trees.push_back(spec);
+
+	spec = new Spec("tree2");
+	spec->build = false;
+	spec->collision = {0, 0, 0, 2, 6, 2};
+	spec->selection = spec->collision;
+	spec->pivot = true;
+	spec->junk = true;
+	spec->health = 10;
+	spec->parts = {
+		(new Part(Thing("models/tree2.stl").smooth()))->paint(0x228B22ff)->translate(-5,-3,0),
+	};
+	spec->materials = {
+		{Item::byName("log")->id, 1},
+	};
+
+	trees.push_back(spec);
+
+	Chunk::generator([=](Chunk *chunk) {
+		for (int y = 0; y < Chunk::size; y++) {
+			for (int x = 0; x < Chunk::size; x++) {
+				float e = chunk->tiles[y][x].elevation;
+				if (e > -0.01) {
+					double n = Sim::noise2D(chunk->x*Chunk::size+x + 2000000, chunk->y*Chunk::size+y + 2000000, 8, 0.6, 0.015);
+					if (n < 0.4 && Sim::random() < 0.04) {
+						Spec *spec = trees[Sim::choose(trees.size())];
+						Entity::create(Entity::next(), spec)
+							.look(Point::South.randomHorizontal())
+							.move((Point){
+								(float)(chunk->x*Chunk::size+x),
+								(e*100.0f) + spec->collision.h/2.0f,
+								(float)(chunk->y*Chunk::size+y),
+							})
+							.materialize()
+						;
+					}
+				}
+			}
+		}
+	});
+
+	spec = new Spec("truck-engineer");
+	spec->collision = {0, 0, 0, 2, 2, 3};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(thingTruckChassisEngineer))->paint(0xffa500ff)->translate(0,0.3,0),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(-0.8,-0.75,-1),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(-0.8,-0.75,0),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(-0.8,-0.75,1),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(0.8,-0.75,-1),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(0.8,-0.75,0),
+		(new Part(thingTruckWheel))->paint(0x444444ff)->translate(0.8,-0.75,1),
+	};
+	spec->health = 100;
+	spec->align = false;
+	spec->pivot = true;
+	spec->vehicle = true;
+	spec->energyConsume = Energy::kW(50);
+	spec->consumeChemical = true;
+	spec->store = true;
+	spec->crafter = true;
+	spec->crafterShowTab = false;
+	spec->crafterManageStore = false;
+	spec->crafterEnergyConsume = Energy::kW(300);
+	spec->recipeTags = {"smelting", "crafting"};
+	spec->capacity = Mass::kg(1000);
+	spec->logistic = true;
+	spec->storeSetLower = true;
+	spec->storeSetUpper = true;
+	spec->generateElectricity = true;
+	spec->energyGenerate = Energy::MW(1);
+	spec->forceDelete = true;
+
+	spec->depot = true;
+	spec->drones = 10;
+
+	spec->costGreedy = 1.3;
+	spec->clearance = 1.5;
+
+	spec->materials = {
+		{ Item::byName("electric-motor")->id, 2 },
+		{ Item::byName("steel-sheet")->id, 2 },
+		{ Item::byName("gear-wheel")->id, 2 },
+		{ Item::byName("circuit-board")->id, 2 },
+	};
+
+	tech = new Tech(Tech::next(), "truck-engineers");
+	tech->tags = {"vehicles"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("truck-engineer"));
+
+	spec = new Spec("truck-hauler");
+	spec->collision = {0, 0, 0, 2, 2, 3};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(thingTruckChassisEngineer))->paint(0xffcc00ff)->translate(0,0.3,0),
+		Spec::byName("truck-engineer")->parts[1],
+		Spec::byName("truck-engineer")->parts[2],
+		Spec::byName("truck-engineer")->parts[3],
+		Spec::byName("truck-engineer")->parts[4],
+		Spec::byName("truck-engineer")->parts[5],
+		Spec::byName("truck-engineer")->parts[6],
+	};
+	spec->health = 100;
+	spec->align = false;
+	spec->vehicle = true;
+	spec->energyConsume = Energy::kW(50);
+	spec->consumeChemical = true;
+	spec->store = true;
+	spec->capacity = Mass::kg(5000);
+	spec->storeSetUpper = true;
+	spec->forceDelete = true;
+	spec->costGreedy = 1.3;
+	spec->clearance = 1.5;
+
+	spec->materials = {
+		{ Item::byName("electric-motor")->id, 2 },
+		{ Item::byName("steel-sheet")->id, 2 },
+		{ Item::byName("gear-wheel")->id, 2 },
+	};
+
+	tech = new Tech(Tech::next(), "truck-haulers");
+	tech->tags = {"vehicles"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("truck-hauler"));
+
+	spec = new Spec("truck-stop");
+	spec->licensed = true;
+	spec->health = 10;
+	spec->collision = {0, 0, 0, 3, 0.1, 3};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/truck-stop.stl")))->paint(0x662222ff),
+	};
+	spec->pivot = true;
+	spec->named = true;
+	spec->vehicleStop = true;
+
+	auto thingDroneChassis = Thing("models/drone-chassis-hd.stl", "models/drone-chassis-ld.stl");
+	auto thingDroneSpars = Thing("models/drone-spars-hd.stl", "models/drone-spars-ld.stl");
+	auto thingDroneRotor = Thing("models/drone-rotor-hd.stl", "models/drone-rotor-ld.stl");
+
+	spec = new Spec("drone");
+	spec->licensed = true;
+	spec->select = false;
+	spec->build = false;
+	spec->health = 10;
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(thingDroneChassis))->paint(0x990000ff),
+		(new Part(thingDroneSpars))->paint(0x444444ff)->rotate(Point::Up, 45),
+		(new PartSpinner(thingDroneRotor, 45))->paint(0x999999ff)->translate(0.3,0.02,0.3),
+		(new PartSpinner(thingDroneRotor, 45))->paint(0x999999ff)->translate(0.3,0.02,-0.3),
+		(new PartSpinner(thingDroneRotor, 45))->paint(0x999999ff)->translate(-0.3,0.02,0.3),
+		(new PartSpinner(thingDroneRotor, 45))->paint(0x999999ff)->translate(-0.3,0.02,-0.3),
+	};
+	spec->align = false;
+	spec->drone = true;
+	spec->droneSpeed = 0.1f;
+	spec->collideBuild = false;
+
+	spec = new Spec("arm");
+	spec->licensed = true;
+	spec->health = 10;
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = spec->collision;
+	spec->arm = true;
+	spec->enable = true;
+	spec->armOffset = 1.0f;
+	spec->armSpeed = 1.0f/60.0f;
+	spec->rotate = true;
+	spec->parts = {
+		(new Part(Thing("models/arm-base-hd.stl", "models/arm-base-ld.stl")))->translate(0,-1.0,0)->paint(0x4169E1ff),
+		(new Part(Thing("models/arm-pillar-hd.stl", "models/arm-pillar-ld.stl")))->translate(0,-1.0,0)->paint(0x4169E1ff),
+		(new Part(Thing("models/arm-telescope1-hd.stl", "models/arm-telescope1-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope2-hd.stl", "models/arm-telescope2-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope3-hd.stl", "models/arm-telescope3-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-grip-hd.stl", "models/arm-grip-ld.stl")))->translate(0,-1.0,0)->paint(0x4169E1ff),
+	};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(10);
+	spec->energyDrain = Energy::W(100);
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("circuit-board")->id, 1 },
+	};
+
+	// Arm states:
+	// 0-359: rotation
+	// 360-n: parking
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (uint i = 0; i < 360; i++) {
+			Mat4 state = Mat4::rotateY((float)i*DEG2RAD);
+
+			float theta = (float)i;
+
+			float a = sin(theta*DEG2RAD)*1.0;
+			float b = cos(theta*DEG2RAD)*0.4;
+			float r = 1.0*0.4 / std::sqrt(a*a + b*b);
+
+			Point t1 = Point::North * (0.0f*r) - Point::North * 0.2f;
+			Point t2 = Point::North * (0.3f*r) - Point::North * 0.2f;
+			Point t3 = Point::North * (0.6f*r) - Point::North * 0.2f;
+			Point g  = Point::North * (0.6f*r) + Point::North * 0.2f;
+
+			Mat4 extend1 = Mat4::translate(t1.x, t1.y, t1.z) * state;
+			Mat4 extend2 = Mat4::translate(t2.x, t2.y, t2.z) * state;
+			Mat4 extend3 = Mat4::translate(t3.x, t3.y, t3.z) * state;
+			Mat4 extendG = Mat4::translate(g.x, g.y, g.z) * state;
+
+			spec->states.push_back({
+				state0,
+				state,
+				extend1,
+				extend2,
+				extend3,
+				extendG,
+			});
+		}
+	}
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (uint i = 0; i < 90; i+=10) {
+			Mat4 state = state0;
+
+			float theta = (float)i;
+
+			float a = sin(theta*DEG2RAD)*1.0;
+			float b = cos(theta*DEG2RAD)*0.1;
+			float r = 1.0*0.1 / std::sqrt(a*a + b*b);
+
+			Point t1 = Point::North * (0.0f*r) - Point::North * 0.2f;
+			Point t2 = Point::North * (0.3f*r) - Point::North * 0.2f;
+			Point t3 = Point::North * (0.6f*r) - Point::North * 0.2f;
+			Point g  = Point::North * (0.6f*r) + Point::North * 0.2f;
+
+			Mat4 extend1 = Mat4::translate(t1.x, t1.y, t1.z) * state;
+			Mat4 extend2 = Mat4::translate(t2.x, t2.y, t2.z) * state;
+			Mat4 extend3 = Mat4::translate(t3.x, t3.y, t3.z) * state;
+			Mat4 extendG = Mat4::translate(g.x, g.y, g.z) * state;
+
+			spec->states.push_back({
+				state0,
+				state,
+				extend1,
+				extend2,
+				extend3,
+				extendG,
+			});
+		}
+	}
+
+	spec = new Spec("long-arm");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = spec->collision;
+	spec->arm = true;
+	spec->enable = true;
+	spec->armOffset = 2.0f;
+	spec->armSpeed =1.0f/60.0f;
+	spec->rotate = true;
+	spec->health = 10;
+	spec->parts = {
+		(new Part(Thing("models/arm-base-hd.stl", "models/arm-base-ld.stl")))->translate(0,-1.0,0)->paint(0xFF4500ff),
+		(new Part(Thing("models/arm-pillar-hd.stl", "models/arm-pillar-ld.stl")))->translate(0,-1.0,0)->paint(0xFF4500ff),
+		(new Part(Thing("models/arm-telescope1-hd.stl", "models/arm-telescope1-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope2-hd.stl", "models/arm-telescope2-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope3-hd.stl", "models/arm-telescope3-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope4-hd.stl", "models/arm-telescope4-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-telescope5-hd.stl", "models/arm-telescope5-ld.stl")))->translate(0,-1.0,0)->paint(0xC0C0C0ff)->gloss(8),
+		(new Part(Thing("models/arm-grip-hd.stl", "models/arm-grip-ld.stl")))->translate(0,-1.0,0)->paint(0xFF4500ff),
+	};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::kW(10);
+	spec->energyDrain = Energy::W(300);
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("circuit-board")->id, 1 },
+	};
+
+	// Arm states:
+	// 0-359: rotation
+	// 360-n: parking
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (uint i = 0; i < 360; i++) {
+			Mat4 state = Mat4::rotateY((float)i*DEG2RAD);
+
+			float theta = (float)i;
+
+			float a = sin(theta*DEG2RAD)*1.0;
+			float b = cos(theta*DEG2RAD)*0.4;
+			float r = 1.0*0.4 / std::sqrt(a*a + b*b);
+
+			Point t1 = Point::North * (0.0f*r) - Point::North * 0.2f;
+			Point t2 = Point::North * (0.4f*r) - Point::North * 0.2f;
+			Point t3 = Point::North * (0.8f*r) - Point::North * 0.2f;
+			Point t4 = Point::North * (1.2f*r) - Point::North * 0.2f;
+			Point t5 = Point::North * (1.6f*r) - Point::North * 0.2f;
+			Point g  = Point::North * (1.6f*r) + Point::North * 0.2f;
+
+			Mat4 extend1 = Mat4::translate(t1.x, t1.y, t1.z) * state;
+			Mat4 extend2 = Mat4::translate(t2.x, t2.y, t2.z) * state;
+			Mat4 extend3 = Mat4::translate(t3.x, t3.y, t3.z) * state;
+			Mat4 extend4 = Mat4::translate(t4.x, t4.y, t4.z) * state;
+			Mat4 extend5 = Mat4::translate(t5.x, t5.y, t5.z) * state;
+			Mat4 extendG = Mat4::translate(g.x, g.y, g.z) * state;
+
+			spec->states.push_back({
+				state0,
+				state,
+				extend1,
+				extend2,
+				extend3,
+				extend4,
+				extend5,
+				extendG,
+			});
+		}
+	}
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (uint i = 0; i < 90; i+=10) {
+			Mat4 state = state0;
+
+			float theta = (float)i;
+
+			float a = sin(theta*DEG2RAD)*1.0;
+			float b = cos(theta*DEG2RAD)*0.1;
+			float r = 1.0*0.1 / std::sqrt(a*a + b*b);
+
+			Point t1 = Point::North * (0.0f*r) - Point::North * 0.2f;
+			Point t2 = Point::North * (0.4f*r) - Point::North * 0.2f;
+			Point t3 = Point::North * (0.8f*r) - Point::North * 0.2f;
+			Point t4 = Point::North * (1.2f*r) - Point::North * 0.2f;
+			Point t5 = Point::North * (1.6f*r) - Point::North * 0.2f;
+			Point g  = Point::North * (1.6f*r) + Point::North * 0.2f;
+
+			Mat4 extend1 = Mat4::translate(t1.x, t1.y, t1.z) * state;
+			Mat4 extend2 = Mat4::translate(t2.x, t2.y, t2.z) * state;
+			Mat4 extend3 = Mat4::translate(t3.x, t3.y, t3.z) * state;
+			Mat4 extend4 = Mat4::translate(t4.x, t4.y, t4.z) * state;
+			Mat4 extend5 = Mat4::translate(t5.x, t5.y, t5.z) * state;
+			Mat4 extendG = Mat4::translate(g.x, g.y, g.z) * state;
+
+			spec->states.push_back({
+				state0,
+				state,
+				extend1,
+				extend2,
+				extend3,
+				extend4,
+				extend5,
+				extendG,
+			});
+		}
+	}
+
+	auto steamEnginewheel = Thing("models/steam-engine-wheel-hd.stl", "models/steam-engine-wheel-ld.stl");
+
+	spec = new Spec("boiler");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 3, 2, 2};
+	spec->selection = spec->collision;
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(1000);
+	spec->pipeConnections = {
+		{1.0f, -0.5f, 1.0f},
+		{1.0f, -0.5f, -1.0f},
+	};
+	spec->pipeOutputConnections = {
+		{-1.5f, -0.5f, 0.5f},
+		{-1.5f, -0.5f, -0.5f},
+	};
+
+	spec->parts = {
+		(new Part(Thing("models/boiler-chassis-hd.stl", "models/boiler-chassis-ld.stl")))->paint(0xB0C4DEff),
+		(new Part(Thing("models/boiler-firebox-hd.stl", "models/boiler-firebox-ld.stl")))->gloss(16)->paint(0x666666ff),
+		(new Part(Thing("models/boiler-stack-hd.stl", "models/boiler-stack-ld.stl")))->gloss(16)->paint(0xda8a67ff),
+		(new Part(Thing("models/boiler-stack-cover-hd.stl", "models/boiler-stack-cover-ld.stl")))->paint(0x000000ff),
+		(new PartSmoke(1200, 10, 0.005, 0.25f, 0.01f, 0.005f, 0.05f, 0.99f, 60, 180))->translate(0.6,1,0),
+	};
+
+	{
+		auto thingRivet = Thing("models/boiler-rivet-hd.stl");
+
+		for (int i = -2; i <= 2; i++) {
+			Mat4 trx = Mat4::rotate(Point::South, -90.0f*DEG2RAD);
+			trx = trx * Mat4::translate(Point::Up*0.5f);
+			trx = trx * Mat4::rotate(Point::East, (float)i*30.0f*DEG2RAD);
+			trx = trx * Mat4::translate(Point::East*1.31f);
+			auto part = (new Part(thingRivet))->ld(false)->paint(0xB0C4DEff);
+			part->transform = part->transform * trx;
+			part->tsrt = part->transform * part->srt;
+			spec->parts.push_back(part);
+		}
+
+		for (int i = -2; i <= 2; i++) {
+			Mat4 trx = Mat4::rotate(Point::South, 90.0f*DEG2RAD);
+			trx = trx * Mat4::translate(Point::Up*0.5f);
+			trx = trx * Mat4::rotate(Point::East, (float)i*30.0f*DEG2RAD);
+			trx = trx * Mat4::translate(Point::East*-1.31f);
+			auto part = (new Part(thingRivet))->ld(false)->paint(0xB0C4DEff);
+			part->transform = part->transform * trx;
+			part->tsrt = part->transform * part->srt;
+			spec->parts.push_back(part);
+		}
+	}
+
+	for (uint i = 0; i < 10; i++) {
+		float fi = (float)i;
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::scale(0.1f*fi, 0.1f*fi, 0.1f*fi),
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+		});
+	}
+
+	for (uint i = 0; i < 80; i++) {
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+		});
+	}
+
+	for (uint i = 0; i < 10; i++) {
+		float fi = (float)(9-i);
+		spec->states.push_back({
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::scale(0.1f*fi, 0.1f*fi, 0.1f*fi),
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+			Mat4::identity,
+		});
+	}
+
+	spec->health = 10;
+	spec->align = true;
+	spec->rotate = true;
+	spec->consumeChemical = true;
+	spec->energyConsume = Energy::MW(2);
+	spec->energyDrain = Energy::kW(60);
+	spec->crafter = true;
+	spec->crafterProgress = true;
+	spec->recipeTags = {"boiling"};
+	spec->materials = {
+		{ Item::byName("brick")->id, 3 },
+		{ Item::byName("copper-sheet")->id, 3 },
+	};
+
+	recipe = new Recipe(Recipe::next(), "boiling");
+	recipe->energyUsage = Energy::MJ(20);
+	recipe->tags = {"boiling"};
+	recipe->inputFluids = {
+		{ Fluid::byName("water")->id, 1000 },
+	};
+	recipe->outputFluids = {
+		{ Fluid::byName("steam")->id, 1000 },
+	};
+	recipe->licensed = true;
+
+	auto steamDroplet = new Part(droplet);
+	steamDroplet->color = Fluid::byName("steam")->color;
+
+	recipe->parts = {steamDroplet};
+
+	spec = new Spec("steam-engine");
+	spec->licensed = true;
+	spec->collision = {0, 0, 0, 4, 4, 5};
+	spec->selection = spec->collision;
+	spec->electrical = { .area = Area(5,6), .rate = Energy::MW(1) };
+	spec->pipe = true;
+	spec->pipeCapacity = Liquid::l(100);
+	spec->pipeConnections = {{-0.5f, -1.5f, 2.5f}, {0.5f, -1.5f, 2.5f}};
+	spec->parts = {
+		(new Part(Thing("models/steam-engine-boiler-hd.stl", "models/steam-engine-boiler-ld.stl")))->gloss(16)->paint(0x708090ff)->translate(0,-2,0),
+		(new Part(Thing("models/steam-engine-saddle-hd.stl", "models/steam-engine-saddle-ld.stl")))->gloss(16)->paint(0x004225ff)->translate(0,-2,0),
+		(new Part(Thing("models/steam-engine-foot-hd.stl", "models/steam-engine-foot-ld.stl")))->gloss(16)->paint(0x004225ff)->translate(0,-2,0),
+		(new Part(Thing("models/steam-engine-axel-hd.stl", "models/steam-engine-axel-ld.stl")))->gloss(16)->paint(0x666666ff)->translate(0,1,1),
+		(new Part(steamEnginewheel))->gloss(8)->paint(0x666666ff)->translate(-1.75,1,1)->rotate(Point::South, 90),
+		(new Part(steamEnginewheel))->gloss(8)->paint(0x666666ff)->translate( 1.75,1,1)->rotate(Point::South, 90),
+	};
+	spec->health = 10;
+	spec->align = true;
+	spec->rotate = true;
+	spec->enable = true;
+	spec->consumeThermalFluid = true;
+	spec->generateElectricity = true;
+	spec->energyGenerate = Energy::MW(1);
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 5 },
+		{ Item::byName("copper-sheet")->id, 5 },
+	};
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (int i = 0; i < 720; i++) {
+			Mat4 state1 = Mat4::rotateY((float)i*DEG2RAD*5.0f);
+
+			spec->states.push_back({
+				state0,
+				state0,
+				state0,
+				state0,
+				state1,
+				state1,
+			});
+		}
+	}
+
+	spec = new Spec("turret");
+	spec->health = 100;
+	spec->collision = {0, 0, 0, 1, 1, 1};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/turret-chassis.stl")))->paint(0x444444ff)->translate(0,-0.5,0),
+		(new Part(Thing("models/turret-dome.stl")))->paint(0x0044ccff)->translate(0,-0.5,0)->pivots(),
+		(new Part(Thing("models/turret-barrel.stl")))->paint(0x444444ff)->translate(0,-0.5,0)->pivots(),
+	};
+	spec->align = true;
+	spec->rotate = true;
+	spec->turret = true;
+	spec->turretRange = 50;
+	spec->turretPivot = 0.1;
+	spec->turretCooldown = 10;
+	spec->turretBulletSpec = "bullet";
+
+	spec = new Spec("bullet");
+	spec->build = false;
+	spec->explodes = true;
+	spec->explosionSpec = "bullet-impact1";
+	spec->health = 0;
+	spec->collision = {0, 0, 0, 0.1, 0.1, 0.1};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/bullet.stl")))->paint(0x660000ff),
+	};
+	spec->align = false;
+	spec->missile = true;
+	spec->missileSpeed = 1.0;
+	spec->missileBallistic = true;
+
+	spec = new Spec("bullet-impact1");
+	spec->build = false;
+	spec->align = false;
+	spec->explosion = true;
+	spec->explosionDamage = 10;
+	spec->explosionRadius = 0.1;
+	spec->explosionRate = 0.01;
+
+	tech = new Tech(Tech::next(), "turrets");
+	tech->tags = {"defence"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("turret"));
+
+	spec = new Spec("missile");
+	spec->explodes = true;
+	spec->explosionSpec = "missile-explosion1";
+	spec->health = 100;
+	spec->collision = {0, 0, 0, 1, 1, 2};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/missile-chassis.stl")))->paint(0x660000ff),
+	};
+	spec->align = false;
+	spec->missile = true;
+
+	spec = new Spec("missile-explosion1");
+	spec->align = false;
+	spec->build = false;
+	spec->explosion = true;
+	spec->explosionDamage = 100;
+	spec->explosionRadius = 10;
+	spec->explosionRate = 0.5;
+
+	tech = new Tech(Tech::next(), "missiles");
+	tech->tags = {"defence"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("missile"));
+
+	spec = new Spec("teleporter");
+	spec->licensed = true;
+	spec->health = 10;
+	spec->store = true;
+	spec->capacity = Mass::kg(10000);
+	spec->loadPriority = true;
+	spec->rotate = true;
+	spec->crafter = true;
+	spec->crafterProgress = false;
+	spec->enable = true;
+	spec->recipeTags = {"teleporting"};
+	spec->consumeElectricity = true;
+	spec->energyConsume = Energy::MW(10);
+	spec->energyDrain = Energy::kW(300);
+	spec->collision = {0, 0, 0, 8, 8, 8};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/teleporter-base-hd.stl")))->paint(0x4682B4ff)->translate(0,-2.5,0),
+		(new Part(Thing("models/teleporter-ring1-hd.stl")))->paint(0xFFD700ff)->gloss(8),
+		(new Part(Thing("models/teleporter-ring2-hd.stl")))->paint(0xFFD700ff)->gloss(8),
+		(new Part(Thing("models/teleporter-ring3-hd.stl")))->paint(0xFFD700ff)->gloss(8),
+	};
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 5 },
+	};
+
+	{
+		Mat4 state0 = Mat4::identity;
+
+		for (int i = 0; i < 360; i+=2) {
+			Mat4 state1 = Mat4::rotateY((float)i*DEG2RAD);
+			Mat4 state2 = Mat4::rotateX((float)i*DEG2RAD);
+			Mat4 state3 = Mat4::rotateZ((float)i*DEG2RAD);
+
+			spec->states.push_back({
+				state0,
+				state1,
+				state2,
+				state3,
+			});
+		}
+	}
+
+	spec = new Spec("computer");
+	spec->health = 10;
+	spec->rotate = true;
+	spec->computer = true;
+	spec->consumeElectricity = true;
+	spec->energyDrain = Energy::W(100);
+	spec->collision = {0, 0, 0, 1, 2, 1};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/computer-rack-hd.stl", "models/computer-rack-ld.stl")))->paint(0x888888ff)->translate(0,-1,0),
+	};
+	spec->materials = {
+		{ Item::byName("steel-sheet")->id, 1 },
+		{ Item::byName("copper-wire")->id, 10 },
+		{ Item::byName("circuit-board")->id, 10 },
+	};
+
+	tech = new Tech(Tech::next(), "computers");
+	tech->tags = {"computation"};
+	tech->cost = Currency::k(10);
+	tech->licenseSpecs.insert(Spec::byName("computer"));
+
+	spec = new Spec("projector");
+	spec->health = 10;
+	spec->projector = true;
+	spec->collision = {0, 0, 0, 1, 0.1, 1};
+	spec->selection = spec->collision;
+	spec->parts = {
+		(new Part(Thing("models/projector.stl")))->paint(0x888888ff),
+		(new PartSmoke(1000, 100, 0.0025, 0.25f, 0.05f, 0.005f, 0.1f, 0.99f, 5, 10))->paint(0xeeeeeeff),
+	};
+
+	recipe = new Recipe(Recipe::next(), "sell-steel-ingots1");
+	recipe->energyUsage = Energy::MJ(100);
+	recipe->tags = {"teleporting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-ingot")->id, 1000 },
+	};
+	recipe->outputCurrency = 1000;
+	recipe->parts = Item::byName("steel-ingot")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "sell-steel-sheet1");
+	recipe->energyUsage = Energy::MJ(100);
+	recipe->tags = {"teleporting"};
+	recipe->inputItems = {
+		{ Item::byName("steel-sheet")->id, 1000 },
+	};
+	recipe->outputCurrency = 1000;
+	recipe->parts = Item::byName("steel-sheet")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "sell-copper-ingots1");
+	recipe->energyUsage = Energy::MJ(100);
+	recipe->tags = {"teleporting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-ingot")->id, 1000 },
+	};
+	recipe->outputCurrency = 1000;
+	recipe->parts = Item::byName("copper-ingot")->parts;
+	recipe->licensed = true;
+
+	recipe = new Recipe(Recipe::next(), "sell-copper-sheet1");
+	recipe->energyUsage = Energy::MJ(100);
+	recipe->tags = {"teleporting"};
+	recipe->inputItems = {
+		{ Item::byName("copper-sheet")->id, 1000 },
+	};
+	recipe->outputCurrency = 1000;
+	recipe->parts = Item::byName("copper-sheet")->parts;
+	recipe->licensed = true;
+}
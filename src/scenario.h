@@ -0,0 +1,6 @@
+#pragma once
+
+// The built-in Items, Fluids, Recipes, Specs and Techs that aren't (yet)
+// defined by mods. Shared by the game and the headless tools.
+
+void scenario();
@@ -5,6 +5,8 @@
 #include "sim.h"
 #include "time-series.h"
 #include <cstdlib>
+#include <chrono>
+#include <thread>
 
 namespace Sim {
 
@@ -37,6 +39,12 @@ namespace Sim {
 	uint64_t tick;
 	int64_t seed;
 
+	std::atomic<uint> ups = 60;
+	std::atomic<uint> catchUp = 10;
+	std::atomic<uint> upsActual = 0;
+	std::atomic<uint64_t> skipped = 0;
+	std::atomic<bool> regions = false;
+
 	void reseed(int64_t s) {
 		seed = s;
 		//std::srand((unsigned)s);
@@ -96,6 +104,47 @@ namespace Sim {
 		mutex.unlock();
 	}
 
+	void run(std::atomic<bool>& running, lockCallback step) {
+		using clock = std::chrono::steady_clock;
+
+		auto next = clock::now();
+		auto second = next;
+		uint count = 0;
+
+		while (running) {
+			auto interval = std::chrono::nanoseconds(1000000000/std::max(1u, ups.load()));
+			auto now = clock::now();
+
+			if (now < next) {
+				std::this_thread::sleep_until(next);
+				continue;
+			}
+
+			for (uint i = 0; running && i < std::max(1u, catchUp.load()) && clock::now() >= next; i++) {
+				locked([&]() {
+					update();
+					step();
+				});
+				next += interval;
+				count++;
+			}
+
+			// still behind after catching up; drop the backlog
+			now = clock::now();
+			if (now >= next) {
+				uint64_t behind = (now - next) / interval + 1;
+				skipped += behind;
+				next += interval * behind;
+			}
+
+			if (now - second >= std::chrono::seconds(1)) {
+				upsActual = count;
+				count = 0;
+				second = now;
+			}
+		}
+	}
+
 	double noise2D(double x, double y, int layers, double persistence, double frequency) {
 		double amp = 1.0;
 		double ampSum = 0.0;
@@ -119,15 +168,17 @@ namespace Sim {
 
 		Point n = (b-a).normalize();
 
-		for (Point c = a; c.distance(b) > 1.0f; c += n) {
-			for (int eid: Entity::intersecting(c.box().grow(clearance))) {
-				if (collide(eid)) {
-					return false;
-				}
-			}
+		bool clear = true;
+		for (Point c = a; clear && c.distance(b) > 1.0f; c += n) {
+			Box box = c.box().grow(clearance);
+			if (Chunk::vacant(box)) continue;
+			Entity::forEachIntersecting(box, [&](uint eid) {
+				clear = !collide(eid);
+				return clear;
+			});
 		}
 
-		return true;
+		return clear;
 	}
 
 	void update() {
@@ -137,26 +188,38 @@ namespace Sim {
 		statsElectricitySupply.update(tick);
 
 		tick++;
-		statsEntity.track(tick, Entity::preTick);
-		statsGhost.track(tick, Ghost::tick);
-		statsPipe.track(tick, Pipe::tick);
-		statsStore.track(tick, Store::tick);
-		statsArm.track(tick, Arm::tick);
-		statsCrafter.track(tick, Crafter::tick);
-		statsProjector.track(tick, Projector::tick);
-		statsPath.track(tick, Path::tick);
-		statsVehicle.track(tick, Vehicle::tick);
-		statsConveyor.track(tick, Conveyor::tick);
-		statsUnveyor.track(tick, Unveyor::tick);
-		statsLoader.track(tick, Loader::tick);
-		statsRopeway.track(tick, Ropeway::tick);
-		statsRopewayBucket.track(tick, RopewayBucket::tick);
-		statsDepot.track(tick, Depot::tick);
-		statsDrone.track(tick, Drone::tick);
-		statsMissile.track(tick, Missile::tick);
-		statsExplosion.track(tick, Explosion::tick);
-		statsTurret.track(tick, Turret::tick);
-		statsComputer.track(tick, Computer::tick);
+		statsEntity.sample(tick, Entity::preTick);
+		statsGhost.sample(tick, Ghost::tick);
+		statsPipe.sample(tick, Pipe::tick);
+		statsStore.sample(tick, Store::tick);
+		statsArm.sample(tick, Arm::tick);
+		statsCrafter.sample(tick, Crafter::tick);
+		statsProjector.sample(tick, Projector::tick);
+		statsPath.sample(tick, Path::tick);
+		statsVehicle.sample(tick, Vehicle::tick);
+		statsConveyor.sample(tick, Conveyor::tick);
+		statsUnveyor.sample(tick, Unveyor::tick);
+		statsLoader.sample(tick, Loader::tick);
+		statsRopeway.sample(tick, Ropeway::tick);
+		statsRopewayBucket.sample(tick, RopewayBucket::tick);
+		statsDepot.sample(tick, Depot::tick);
+		statsDrone.sample(tick, Drone::tick);
+		statsMissile.sample(tick, Missile::tick);
+		statsExplosion.sample(tick, Explosion::tick);
+		statsTurret.sample(tick, Turret::tick);
+		statsComputer.sample(tick, Computer::tick);
+
+		static TimeSeries* series[] = {
+			&statsEntity, &statsGhost, &statsPipe, &statsStore, &statsArm,
+			&statsCrafter, &statsProjector, &statsPath, &statsVehicle,
+			&statsConveyor, &statsUnveyor, &statsLoader, &statsRopeway,
+			&statsRopewayBucket, &statsDepot, &statsDrone, &statsMissile,
+			&statsExplosion, &statsTurret, &statsComputer,
+		};
+
+		for (auto ts: series) {
+			ts->update(tick);
+		}
 	}
 }
 
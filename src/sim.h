@@ -4,6 +4,7 @@
 #include "time-series.h"
 #include "point.h"
 #include <mutex>
+#include <atomic>
 #include <functional>
 
 namespace Sim {
@@ -50,6 +51,17 @@ namespace Sim {
 	typedef std::function<void(void)> lockCallback;
 	void locked(lockCallback cb);
 
+	// The simulation runs on its own thread at a fixed UPS target, decoupled
+	// from the rendering frame rate. When ticks fall behind schedule (a slow
+	// tick, or another thread holding the lock) up to catchUp ticks are run
+	// back-to-back, after which the remaining backlog is skipped rather than
+	// allowed to snowball. catchUp = 1 means never catch up.
+	extern std::atomic<uint> ups;
+	extern std::atomic<uint> catchUp;
+	extern std::atomic<uint> upsActual;
+	extern std::atomic<uint64_t> skipped;
+	void run(std::atomic<bool>& running, lockCallback step);
+
 
 	// decrease persistence to make coastline smoother
 	// increase frequency to make lakes smaller
@@ -60,6 +72,27 @@ namespace Sim {
 	void save(const char *path);
 	void load(const char *path);
 
+	// One simulation tick. Systems run serially in a fixed order. Inside a
+	// system, work that scales with instance count may use Jobs::parallel
+	// under a two-phase model:
+	//   plan   (parallel) may read any sim state, but writes only to the
+	//          component being planned, e.g. Missile::plan, Explosion::plan;
+	//   update (serial) applies cross-entity effects such as moving entities,
+	//          damage or removal, in component iteration order.
+	// The phases are identical when Jobs is disabled, so results do not depend
+	// on thread count. determinism-test checks that tick by tick.
+	// Crafter only plans its animation. Its progress step is a few
+	// multiplies, but it goes through Entity::consume, which adds to the
+	// shared electricityDemand and energyConsumers, and a crafter that starts
+	// a job this tick progresses in the same update. Starting and finishing
+	// jobs move items through stores and pipe networks, mine hills and hit
+	// the Ledger, and later crafters see those effects in iteration order, so
+	// that is where the time goes and none of it can be planned apart.
 	void update();
 
+	// Region mode: systems that support it (so far Conveyor) bucket work by
+	// Chunk and tick each region as a job, followed by a serial boundary
+	// pass for anything that crosses a chunk edge.
+	extern std::atomic<bool> regions;
+
 }
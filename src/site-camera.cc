@@ -7,6 +7,7 @@ SiteCamera::SiteCamera(Point ppos, Point ddir) {
 	pos = ppos;
 	dir = ddir.normalize();
 	refresh = 60;
+	frame = 0;
 }
 
 SiteCamera::~SiteCamera() {
@@ -22,7 +23,7 @@ Point SiteCamera::groundTarget(float ground) {
 }
 
 void SiteCamera::update(bool worldFocused) {
-	if (Sim::tick%refresh != 0) return;
+	if (frame++%refresh != 0) return;
 
 	while (entities.size() > 0) {
 		delete entities.back();
@@ -40,7 +41,7 @@ void SiteCamera::update(bool worldFocused) {
 }
 
 void SiteCamera::draw(RenderTexture canvas) {
-	if (Sim::tick%refresh != 0) return;
+	if ((frame-1)%refresh != 0) return;
 
 	Camera3D camera = {
 		.position = pos,
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cassert>
+#include "common.h"
+
+// Index layouts for slabmap, chosen by its last template parameter. Both
+// map a key to the slot holding its value. Slot types (S) carry a slabslot
+// ss plus match(pool, key) and keyOf(pool), so an index never needs to know
+// how values are stored.
+
+// Table widths for both layouts: primes just under successive powers of
+// two, so keys with regular strides or packed fields still spread evenly.
+
+struct slabwidth {
+	uint power2;
+	uint prime;
+};
+
+inline const std::vector<slabwidth> slabwidths = {
+	{ .power2 = 8, .prime = 7 },
+	{ .power2 = 16, .prime = 13 },
+	{ .power2 = 32, .prime = 31 },
+	{ .power2 = 64, .prime = 61,} ,
+	{ .power2 = 128, .prime = 127 },
+	{ .power2 = 256, .prime = 251 },
+	{ .power2 = 512, .prime = 509 },
+	{ .power2 = 1024, .prime = 1021 },
+	{ .power2 = 2048, .prime = 2039 },
+	{ .power2 = 4096, .prime = 4093 },
+	{ .power2 = 8192, .prime = 8191 },
+	{ .power2 = 16384, .prime = 16381 },
+	{ .power2 = 32768, .prime = 32749 },
+	{ .power2 = 65536, .prime = 65521 },
+	{ .power2 = 131072, .prime = 131071 },
+	{ .power2 = 262144, .prime = 262139 },
+	{ .power2 = 524288, .prime = 524287 },
+	{ .power2 = 1048576, .prime = 1048573 },
+	{ .power2 = 2097152, .prime = 2097143 },
+	{ .power2 = 4194304, .prime = 4194301 },
+	{ .power2 = 8388608, .prime = 8388593 },
+	{ .power2 = 16777216, .prime = 16777213 },
+	{ .power2 = 33554432, .prime = 33554393 },
+	{ .power2 = 67108864, .prime = 67108859 },
+	{ .power2 = 134217728, .prime = 134217689 },
+	{ .power2 = 268435456, .prime = 268435399 },
+	{ .power2 = 536870912, .prime = 536870909 },
+	{ .power2 = 1073741824, .prime = 1073741789 },
+	{ .power2 = 2147483648, .prime = 2147483647 },
+};
+
+// Prime-width hash table of vector buckets. Each bucket is its own heap
+// allocation, but chains of a few slots are cheap to scan and tolerate
+// high load factors. Resizing is incremental: the old table drains into
+// the new one a couple of buckets per insert/erase.
+
+template <typename K, typename S>
+class slabchains {
+	typedef std::vector<std::vector<S>> table;
+
+	table index;
+	table draining;
+	uint drained = 0;
+
+	// position of index in widths
+	uint width = 0;
+
+	std::hash<K> hash;
+
+	std::size_t chain(const table& t, const K& k) const {
+		assert(t.size() > 0);
+		return hash(k) % t.size();
+	}
+
+	template <typename P>
+	void drain(const P& pool, uint buckets) {
+		for (; buckets && drained < draining.size(); buckets--, drained++) {
+			for (S ref: draining[drained]) {
+				index[chain(index, ref.keyOf(pool))].push_back(ref);
+			}
+			std::vector<S>().swap(draining[drained]);
+		}
+		if (drained == draining.size()) {
+			table().swap(draining);
+			drained = 0;
+		}
+	}
+
+	template <typename P>
+	void resize(const P& pool, uint w) {
+		drain(pool, draining.size());
+		width = w;
+		if (index.empty()) {
+			index.resize(slabwidths[w].prime);
+			return;
+		}
+		draining.swap(index);
+		index.resize(slabwidths[w].prime);
+		drained = 0;
+	}
+
+public:
+
+	// buckets are vectors, so interating a bit on collision is cheap
+	static constexpr float defaultLoad = 4.0f;
+
+	bool empty() const {
+		return index.empty();
+	}
+
+	template <typename P>
+	const S* locate(const P& pool, const K& k) const {
+		for (const S& ref: index[chain(index, k)]) {
+			if (ref.match(pool, k)) return &ref;
+		}
+
+		if (draining.size()) {
+			for (const S& ref: draining[chain(draining, k)]) {
+				if (ref.match(pool, k)) return &ref;
+			}
+		}
+		return nullptr;
+	}
+
+	template <typename P>
+	void insert(const P& pool, const K& k, S s) {
+		index[chain(index, k)].push_back(s);
+	}
+
+	template <typename P>
+	bool erase(const P& pool, const K& k, S& out) {
+		for (table* t: {&index, &draining}) {
+			if (!t->size()) continue;
+
+			auto& bucket = (*t)[chain(*t, k)];
+
+			for (auto it = bucket.begin(); it != bucket.end(); it++) {
+				if (it->match(pool, k)) {
+					out = *it;
+					bucket.erase(it);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// point k's slot somewhere else; the old slot is already vacated so
+	// this compares slots rather than calling match()
+	template <typename SS>
+	void relocate(const K& k, SS from, SS to) {
+		for (table* t: {&index, &draining}) {
+			if (!t->size()) continue;
+			for (S& ref: (*t)[chain(*t, k)]) {
+				if (ref.ss.slab == from.slab && ref.ss.cell == from.cell) {
+					ref.ss = to;
+					return;
+				}
+			}
+		}
+		assert(false);
+	}
+
+	// Grow past load, shrink below a quarter of it. Either move leaves the
+	// new load factor at half of the old one, well clear of both thresholds,
+	// so churn around a boundary can't flip-flop.
+	template <typename P>
+	void reindex(const P& pool, uint size, float load) {
+		if (index.empty()) {
+			resize(pool, 0);
+			return;
+		}
+
+		// two buckets per operation finishes well before the next resize
+		if (draining.size()) {
+			drain(pool, 2);
+		}
+
+		float current = (float)size/(float)slabwidths[width].power2;
+
+		if (current > load && slabwidths.size()-1 > width) {
+			resize(pool, width+1);
+		}
+		else
+		if (current < (load*0.25f) && width > 0) {
+			resize(pool, width-1);
+		}
+	}
+
+	template <typename P>
+	void reserve(const P& pool, uint n, float load) {
+		uint w = width;
+		while ((float)n/(float)slabwidths[w].power2 > load && slabwidths.size()-1 > w) {
+			w++;
+		}
+		if (w > width || index.empty()) {
+			resize(pool, w);
+			drain(pool, draining.size());
+		}
+	}
+
+	void clear() {
+		table().swap(index);
+		table().swap(draining);
+		drained = 0;
+		width = 0;
+	}
+};
+
+// Prime-width open-addressed table with Robin Hood probing: one flat array,
+// no per-bucket allocations, and lookups stop as soon as they meet an entry
+// closer to its home than the probe is. Erase shifts followers back rather
+// than leaving tombstones. Resizing rehashes in one pass, so bulk loads
+// should reserve() first.
+
+template <typename K, typename S>
+class slabflat {
+	struct entry {
+		S slot;
+		// probe distance from home plus one; zero is empty
+		uint dist = 0;
+	};
+
+	std::vector<entry> entries;
+	uint used = 0;
+
+	// position of entries in slabwidths
+	uint width = 0;
+
+	std::hash<K> hash;
+
+	// Keys are used as-is modulo a prime, like slabchains, so sequential ids
+	// land in sequential entries. Linear probing is less forgiving of keys
+	// that pile into one region than chained buckets are, so structured keys
+	// (packed coordinates) should be scrambled by the caller.
+	std::size_t home(const K& k) const {
+		return hash(k) % entries.size();
+	}
+
+	std::size_t next(std::size_t i) const {
+		return ++i == entries.size() ? 0: i;
+	}
+
+	template <typename P>
+	void place(const P& pool, const K& k, S s) {
+		entry e = { .slot = s, .dist = 1 };
+		for (std::size_t i = home(k);; i = next(i), e.dist++) {
+			if (!entries[i].dist) {
+				entries[i] = e;
+				used++;
+				return;
+			}
+			if (entries[i].dist < e.dist) {
+				std::swap(entries[i], e);
+			}
+		}
+	}
+
+	template <typename P>
+	void rehash(const P& pool, uint w) {
+		std::vector<entry> old;
+		old.swap(entries);
+		width = w;
+		entries.resize(slabwidths[w].prime);
+		used = 0;
+		for (auto& e: old) {
+			if (e.dist) place(pool, e.slot.keyOf(pool), e.slot);
+		}
+	}
+
+	uint fit(uint n, float load) const {
+		uint w = 0;
+		while ((float)n > (float)slabwidths[w].prime * load && slabwidths.size()-1 > w) w++;
+		return w;
+	}
+
+public:
+
+	static constexpr float defaultLoad = 0.8f;
+
+	bool empty() const {
+		return entries.empty();
+	}
+
+	template <typename P>
+	const S* locate(const P& pool, const K& k) const {
+		std::size_t i = home(k);
+		for (uint d = 1; entries[i].dist >= d; i = next(i), d++) {
+			if (entries[i].slot.match(pool, k)) return &entries[i].slot;
+		}
+		return nullptr;
+	}
+
+	template <typename P>
+	void insert(const P& pool, const K& k, S s) {
+		place(pool, k, s);
+	}
+
+	template <typename P>
+	bool erase(const P& pool, const K& k, S& out) {
+		if (entries.empty()) return false;
+
+		std::size_t i = home(k);
+		for (uint d = 1; entries[i].dist >= d; i = next(i), d++) {
+			if (entries[i].slot.match(pool, k)) {
+				out = entries[i].slot;
+				// backward-shift followers that probed past this entry
+				for (std::size_t j = next(i); entries[j].dist > 1; i = j, j = next(j)) {
+					entries[i] = entries[j];
+					entries[i].dist--;
+				}
+				entries[i] = entry();
+				used--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <typename SS>
+	void relocate(const K& k, SS from, SS to) {
+		std::size_t i = home(k);
+		for (uint d = 1; entries[i].dist >= d; i = next(i), d++) {
+			S& ref = entries[i].slot;
+			if (ref.ss.slab == from.slab && ref.ss.cell == from.cell) {
+				ref.ss = to;
+				return;
+			}
+		}
+		assert(false);
+	}
+
+	// Same hysteresis as slabchains: grow past load, shrink below a quarter.
+	// Load is capped so an insert always finds an empty entry.
+	template <typename P>
+	void reindex(const P& pool, uint size, float load) {
+		load = std::min(load, 0.95f);
+		if (entries.empty()) {
+			rehash(pool, fit(size, load));
+			return;
+		}
+
+		if ((float)size > (float)entries.size() * load && slabwidths.size()-1 > width) {
+			rehash(pool, width+1);
+		}
+		else
+		if ((float)size < (float)entries.size() * load * 0.25f && width > 0) {
+			rehash(pool, width-1);
+		}
+	}
+
+	template <typename P>
+	void reserve(const P& pool, uint n, float load) {
+		uint w = fit(n, std::min(load, 0.95f));
+		if (w > width || entries.empty()) rehash(pool, w);
+	}
+
+	void clear() {
+		std::vector<entry>().swap(entries);
+		used = 0;
+		width = 0;
+	}
+};
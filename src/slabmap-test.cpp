@@ -14,6 +14,7 @@ int main(int argc, char const *argv[]) {
 	uint values = 1000000;
 
 	bool sm = false;
+	bool sf = false;
 	bool um = false;
 
 	notef("%u", sizeof(std::vector<uint>));
@@ -22,6 +23,9 @@ int main(int argc, char const *argv[]) {
 		if (std::string(argv[i]) == "--slabmap") {
 			sm = true;
 		}
+		if (std::string(argv[i]) == "--slabflat") {
+			sf = true;
+		}
 		if (std::string(argv[i]) == "--unordered_map") {
 			um = true;
 		}
@@ -37,19 +41,31 @@ int main(int argc, char const *argv[]) {
 
 	std::unordered_map<uint,item> umap;
 
-	for (uint i = 0; i < values; i++) {
-		umap[i] = (item){.id = i, .val = i%17 };
-	}
-
 	slabmap<item,&item::id> smap;
 	smap.load = 1.0f;
 
-	for (uint i = 0; i < values; i++) {
-		smap[i] = (item){.id = i, .val = i%17 };
-	}
+	slabmap<item,&item::id,1024,slabflat> sfmap;
 
 	uint64_t n = 0;
 
+	// Insert and erase run once over all keys; erase removes every other
+	// key, and insert puts them back so lookup and iterate see the full set.
+
+	auto umInsert = [&]() {
+		for (uint i = 0; i < values; i++) {
+			umap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
+	auto umErase = [&]() {
+		for (uint i = 0; i < values; i += 2) {
+			umap.erase(i);
+		}
+		for (uint i = 0; i < values; i += 2) {
+			umap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
 	auto umLookup = [&]() {
 		n = 0;
 		for (uint i = 0; i < passes; i++) {
@@ -68,6 +84,21 @@ int main(int argc, char const *argv[]) {
 		}
 	};
 
+	auto smInsert = [&]() {
+		for (uint i = 0; i < values; i++) {
+			smap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
+	auto smErase = [&]() {
+		for (uint i = 0; i < values; i += 2) {
+			smap.erase(i);
+		}
+		for (uint i = 0; i < values; i += 2) {
+			smap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
 	auto smLookup = [&]() {
 		n = 0;
 		for (uint i = 0; i < passes; i++) {
@@ -86,15 +117,59 @@ int main(int argc, char const *argv[]) {
 		}
 	};
 
+	auto sfInsert = [&]() {
+		for (uint i = 0; i < values; i++) {
+			sfmap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
+	auto sfErase = [&]() {
+		for (uint i = 0; i < values; i += 2) {
+			sfmap.erase(i);
+		}
+		for (uint i = 0; i < values; i += 2) {
+			sfmap[i] = (item){.id = i, .val = i%17 };
+		}
+	};
+
+	auto sfLookup = [&]() {
+		n = 0;
+		for (uint i = 0; i < passes; i++) {
+			for (uint i = 0; i < values; i++) {
+				n += sfmap[i].val;
+			}
+		}
+	};
+
+	auto sfIterate = [&]() {
+		n = 0;
+		for (uint i = 0; i < passes; i++) {
+			for (auto it = sfmap.begin(); it != sfmap.end(); ++it) {
+				n += (*it).val;
+			}
+		}
+	};
+
 	if (um) {
+		bench("unordered_map insert", umInsert);
+		bench("unordered_map erase", umErase);
 		bench("unordered_map lookup", umLookup);
 		bench("unordered_map iterate", umIterate);
 	}
 
 	if (sm) {
+		bench("slabmap insert", smInsert);
+		bench("slabmap erase", smErase);
 		bench("slabmap lookup", smLookup);
 		bench("slabmap iterate", smIterate);
 	}
 
+	if (sf) {
+		bench("slabmap/slabflat insert", sfInsert);
+		bench("slabmap/slabflat erase", sfErase);
+		bench("slabmap/slabflat lookup", sfLookup);
+		bench("slabmap/slabflat iterate", sfIterate);
+	}
+
 	return 0;
-}
\ No newline at end of file
+}
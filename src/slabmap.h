@@ -8,42 +8,47 @@
 #include <typeinfo>
 #include "common.h"
 #include "slabpool.h"
+#include "slabindex.h"
 #include "minivec.h"
 
 // A hash-table/slab-allocator that:
 // - stores objects that contain their own key as a hashable field
 // - allocates object memory in pages (iteration locality)
-// - vectors for hash buckets (lookup locality, higher load factors)
+// - vectors for hash buckets (lookup locality, higher load factors), or a
+//   flat open-addressed table; see slabindex.h
+
+// A key plus the slot and generation it last resolved to. Converts to and
+// from the bare key so it can stand in for an id field; slabmap::find()
+// resolves it without hashing while the cached slot is current, and falls
+// back to a key lookup (refreshing the cache) when the value has moved or gone.
+
+template <typename K>
+struct slabhandle {
+	K key = K();
+	uint slab = 0;
+	uint cell = 0;
+	uint gen = 0;
+
+	slabhandle() {
+	}
 
-template <class V, auto ID, uint slabSize = 1024>
-class slabmap {
-private:
+	slabhandle(const K& k) {
+		key = k;
+	}
 
-	struct power2prime {
-		uint power2;
-		uint prime;
-	};
+	slabhandle& operator=(const K& k) {
+		if (!(k == key)) *this = slabhandle(k);
+		return *this;
+	}
 
-	static inline std::vector<power2prime> widths = {
-		{ .power2 = 8, .prime = 7 },
-		{ .power2 = 16, .prime = 13 },
-		{ .power2 = 32, .prime = 31 },
-		{ .power2 = 64, .prime = 61,} ,
-		{ .power2 = 128, .prime = 127 },
-		{ .power2 = 256, .prime = 251 },
-		{ .power2 = 512, .prime = 509 },
-		{ .power2 = 1024, .prime = 1021 },
-		{ .power2 = 2048, .prime = 2039 },
-		{ .power2 = 4096, .prime = 4093 },
-		{ .power2 = 8192, .prime = 8191 },
-		{ .power2 = 16384, .prime = 16381 },
-		{ .power2 = 32768, .prime = 32749 },
-		{ .power2 = 65536, .prime = 65521 },
-		{ .power2 = 131072, .prime = 131071 },
-		{ .power2 = 262144, .prime = 262139 },
-		{ .power2 = 524288, .prime = 524287 },
-		{ .power2 = 1048576, .prime = 1048573 },
-	};
+	operator const K&() const {
+		return key;
+	}
+};
+
+template <class V, auto ID, uint slabSize = 1024, template <typename,typename> class layout = slabchains>
+class slabmap {
+private:
 
 	typedef typename std::remove_reference<decltype(std::declval<V>().*ID)>::type K;
 
@@ -71,6 +76,10 @@ private:
 		bool match(const slabpool<V,slabSize>& pool, const K& k) const {
 			return pool.referSlot(ss).*ID == k;
 		}
+
+		const K& keyOf(const slabpool<V,slabSize>& pool) const {
+			return pool.referSlot(ss).*ID;
+		}
 	};
 
 	// Index bucket slots that store a copy of the key.
@@ -96,84 +105,55 @@ private:
 			assert(pool.referSlot(ss).*ID == key);
 			return key == k;
 		}
+
+		const K& keyOf(const slabpool<V,slabSize>& pool) const {
+			return key;
+		}
 	};
 
 	// determines how keys are indexed
 	typedef typename std::conditional<sizeof(K) <= sizeof(void*),kslot,pslot>::type slot;
 
-	std::vector<std::vector<slot>> index;
+	layout<K,slot> index;
 
-	bool match(const slot& s, const K& k) const {
-		return s.match(pool, k);
-	}
-
-	std::hash<K> hash;
-
-	std::size_t chain(const K& k) const {
-		assert(index.size() > 0);
-		return hash(k) % index.size();
+	const slot* locate(const K& k) const {
+		if (pool.empty()) return nullptr;
+		return index.locate(pool, k);
 	}
 
 public:
 
-	slabmap<V,ID,slabSize>() {
+	slabmap<V,ID,slabSize,layout>() {
 	}
 
-	~slabmap<V,ID,slabSize>() {
+	~slabmap<V,ID,slabSize,layout>() {
 		clear();
 	}
 
-	// buckets are vectors, so interating a bit on collision is cheap
-	float load = 4.0f;
+	float load = layout<K,slot>::defaultLoad;
 
 	void reindex() {
-		uint w = 0;
-
-		for (uint i = 0; w == 0 && i < widths.size(); i++) {
-			if (widths[i].prime == index.size()) {
-				w = i;
-			}
-		}
-
-		assert(w >= 0);
-
-		float current = (float)pool.size()/(float)widths[w].power2;
-
-		if (current > load && widths.size()-1 > w) {
-			w++;
-		}
-
-		if (current < (load*0.5f) && w > 0) {
-			w--;
-		}
+		index.reindex(pool, pool.size(), load);
+	}
 
-		if (widths[w].prime != index.size()) {
-			index.clear();
-			index.shrink_to_fit();
-			index.resize(widths[w].prime);
-			for (auto it = pool.begin(); it != pool.end(); ++it) {
-				auto& v = *it;
-				auto& k = v.*ID;
-				index[chain(k)].push_back(slot(it.slot(), k));
-			}
-		}
+	// Size the index for n entries up front, so a bulk load doesn't step
+	// through every intermediate width.
+	void reserve(uint n) {
+		index.reserve(pool, n, load);
+		pool.reserve(n);
 	}
 
 	void clear() {
 		pool.clear();
 		index.clear();
-		index.shrink_to_fit();
 	}
 
-	bool has(const K& k) const {
-		if (pool.empty()) return false;
+	uint size() const {
+		return pool.size();
+	}
 
-		for (slot ref: index[chain(k)]) {
-			if (match(ref, k)) {
-				return true;
-			}
-		}
-		return false;
+	bool has(const K& k) const {
+		return locate(k) != nullptr;
 	}
 
 	bool contains(const K& k) const {
@@ -187,51 +167,76 @@ public:
 	bool erase(const K& k) {
 		if (pool.empty()) return false;
 
-		auto& bucket = index[chain(k)];
-
-		for (auto it = bucket.begin(); it != bucket.end(); it++) {
-			auto& ref = *it;
-			if (match(ref, k)) {
-				pool.releaseSlot(ref.ss);
-				bucket.erase(it);
-				reindex();
-				return true;
-			}
+		slot ref;
+		if (index.erase(pool, k, ref)) {
+			pool.releaseSlot(ref.ss);
+			reindex();
+			return true;
 		}
 		return false;
 	}
 
 	V& refer(const K& k) const {
-		if (pool.empty()) throw k;
-
-		for (slot ref: index[chain(k)]) {
-			if (match(ref, k)) {
-				return pool.referSlot(ref.ss);
-			}
-		}
-		throw k;
+		const slot* ref = locate(k);
+		if (!ref) throw k;
+		return pool.referSlot(ref->ss);
 	}
 
 	V& operator[](const K& k) {
-		if (pool.empty()) reindex();
+		const slot* ref = locate(k);
+		if (ref) return pool.referSlot(ref->ss);
 
-		for (slot ref: index[chain(k)]) {
-			if (match(ref, k)) {
-				return pool.referSlot(ref.ss);
-			}
-		}
+		if (index.empty()) reindex();
 
 		slabslot ss = pool.requestSlot();
 		V& v = pool.referSlot(ss);
 
 		v.*ID = k;
-		index[chain(k)].push_back(slot(ss, k));
+		index.insert(pool, k, slot(ss, k));
 
 		reindex();
 
 		return v;
 	}
 
+	V* find(slabhandle<K>& h) const {
+		if (h.gen && pool.current(h.slab, h.cell, h.gen)) {
+			return &pool.referSlot(slabslot(h.slab, h.cell));
+		}
+
+		h.gen = 0;
+
+		const slot* ref = locate(h.key);
+		if (!ref) return nullptr;
+
+		h.slab = ref->ss.slab;
+		h.cell = ref->ss.cell;
+		h.gen = pool.generation(ref->ss);
+		return &pool.referSlot(ref->ss);
+	}
+
+	bool has(slabhandle<K>& h) const {
+		return find(h) != nullptr;
+	}
+
+	V& refer(slabhandle<K>& h) const {
+		V* v = find(h);
+		if (!v) throw h.key;
+		return *v;
+	}
+
+	// Pack values into as few pages as possible. Invalidates pointers and
+	// references to values, so only for types nothing else points at.
+	void compact() {
+		pool.compact([&](slabslot from, slabslot to) {
+			index.relocate(pool.referSlot(to).*ID, from, to);
+		});
+	}
+
+	bool sparse() const {
+		return pool.sparse();
+	}
+
 	typedef typename slabpool<V,slabSize>::iterator iterator;
 
 	iterator begin() {
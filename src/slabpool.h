@@ -17,11 +17,18 @@ public:
 
 	size_type entries = 0;
 
+	// Occupancy is a bitmap of 64-bit words plus a live count per page, so
+	// iteration skips empty runs a word at a time and empty pages entirely.
+
 	class slabpage {
 
 		#define vsize (((sizeof(V) + alignof(V) - 1) / alignof(V)) * alignof(V))
+		#define wsize ((slabSize + 63) / 64)
+
+		uint64_t bits[wsize];
 
-		bool flags[slabSize];
+		// pool-wide stamp taken when each cell was last occupied
+		uint gens[slabSize];
 
 		// prevents C++ automatically calling V destructors
 		char buffer[vsize * slabSize];
@@ -34,29 +41,67 @@ public:
 		}
 
 	public:
+		uint count = 0;
+
 		slabpage() {
-			for (uint i = 0; i < slabSize; i++) {
-				flags[i] = false;
+			for (uint w = 0; w < wsize; w++) {
+				bits[w] = 0;
 			}
 		}
 
 		~slabpage() {
-			for (uint i = 0; i < slabSize; i++) {
-				if (flags[i]) drop(i);
+			for (uint i = next(0); i < slabSize; i = next(i+1)) {
+				drop(i);
 			}
 		}
 
 		bool used(uint i) const {
 			assert(i < slabSize);
-			return flags[i];
+			return bits[i/64] & (1ull << (i%64));
+		}
+
+		// first used cell at or after i, or slabSize
+		uint next(uint i) const {
+			if (i >= slabSize) return slabSize;
+			uint w = i/64;
+			uint64_t word = bits[w] & (~0ull << (i%64));
+			while (!word) {
+				if (++w == wsize) return slabSize;
+				word = bits[w];
+			}
+			return std::min(slabSize, w*64 + (uint)__builtin_ctzll(word));
 		}
 
-		void use(uint i) {
+		// first free cell at or after i, or slabSize
+		uint vacant(uint i) const {
+			if (i >= slabSize) return slabSize;
+			uint w = i/64;
+			uint64_t word = ~bits[w] & (~0ull << (i%64));
+			while (!word) {
+				if (++w == wsize) return slabSize;
+				word = ~bits[w];
+			}
+			return std::min(slabSize, w*64 + (uint)__builtin_ctzll(word));
+		}
+
+		void use(uint i, uint gen) {
 			assert(!used(i));
-			flags[i] = true;
+			bits[i/64] |= (1ull << (i%64));
+			gens[i] = gen;
+			count++;
 			new (&cell(i)) V;
 		}
 
+		// move-construct into free cell i from used cell j of another page
+		void adopt(uint i, slabpage* from, uint j, uint gen) {
+			assert(!used(i) && from->used(j));
+			bits[i/64] |= (1ull << (i%64));
+			gens[i] = gen;
+			count++;
+			new (&cell(i)) V(std::move(from->cell(j)));
+			from->drop(j);
+		}
+
 		uint cellOf(const V* ptr) const {
 			const char* p = reinterpret_cast<const char*>(ptr);
 			V* a = &cell(0);
@@ -66,14 +111,21 @@ public:
 
 		void drop(uint i) {
 			assert(used(i));
-			flags[i] = false;
+			bits[i/64] &= ~(1ull << (i%64));
+			count--;
 			std::destroy_at(&cell(i));
 		}
 
+		uint generation(uint i) const {
+			return gens[i];
+		}
+
 		V& refer(uint i) const {
 			assert(used(i));
 			return cell(i);
 		}
+
+		#undef wsize
 	};
 
 	std::vector<slabpage*> slabs;
@@ -95,6 +147,14 @@ public:
 
 	std::vector<slabslot> queue;
 
+	// never reset, so a generation identifies one occupancy for the pool's life
+	uint stamp = 0;
+
+	uint nextStamp() {
+		if (!++stamp) ++stamp;
+		return stamp;
+	}
+
 	slabpool<V,slabSize>() {
 	}
 
@@ -111,6 +171,10 @@ public:
 		entries = 0;
 	}
 
+	void reserve(size_type n) {
+		slabs.reserve((n + slabSize - 1) / slabSize);
+	}
+
 	bool empty() const {
 		return !entries;
 	}
@@ -130,7 +194,7 @@ public:
 		slabslot next = queue.back();
 		queue.pop_back();
 
-		slabs[next.slab]->use(next.cell);
+		slabs[next.slab]->use(next.cell, nextStamp());
 		entries++;
 
 		return next;
@@ -145,6 +209,57 @@ public:
 		queue.push_back(slot);
 	}
 
+	// Move values from the last pages into free cells in earlier pages, then
+	// free the empty pages left at the tail. moved(from, to) is called for
+	// each relocation so an owner can fix up its own index. Any pointers or
+	// references to moved values are invalidated.
+	void compact(std::function<void(slabslot,slabslot)> moved) {
+		uint lo = 0;
+		uint hi = slabs.size();
+
+		while (lo < hi) {
+			if (slabs[lo]->count == slabSize) { lo++; continue; }
+			if (!slabs[hi-1]->count) { hi--; continue; }
+			if (lo == hi-1) break;
+
+			slabpage* src = slabs[hi-1];
+			slabpage* dst = slabs[lo];
+			uint j = src->next(0);
+			uint i = dst->vacant(0);
+
+			dst->adopt(i, src, j, nextStamp());
+			moved(slabslot(hi-1, j), slabslot(lo, i));
+		}
+
+		while (slabs.size() && !slabs.back()->count) {
+			delete slabs.back();
+			slabs.pop_back();
+		}
+
+		// lowest free cells are handed out first, as with fresh pages
+		queue.clear();
+		for (int si = slabs.size()-1; si >= 0; si--) {
+			for (int ci = slabSize-1; ci >= 0; ci--) {
+				if (!slabs[si]->used(ci)) queue.push_back(slabslot(si, ci));
+			}
+		}
+		queue.shrink_to_fit();
+	}
+
+	// Worth compacting when live values would fit in half the pages.
+	bool sparse() const {
+		return slabs.size() > 1 && entries*2 < (slabs.size()-1)*slabSize;
+	}
+
+	uint generation(slabslot slot) const {
+		return slabs[slot.slab]->generation(slot.cell);
+	}
+
+	// true if slot is still occupied by the value it held at generation gen
+	bool current(uint slab, uint cell, uint gen) const {
+		return slab < slabs.size() && slabs[slab]->used(cell) && slabs[slab]->generation(cell) == gen;
+	}
+
 	V& referSlot(slabslot slot) const {
 		return slabs[slot.slab]->refer(slot.cell);
 	}
@@ -211,19 +326,14 @@ public:
 		}
 
 		iterator& operator++() {
-			while (!end) {
-				ci++;
-				if (ci == slabSize) {
-					ci = 0;
-					si++;
-				}
-				if (sm->slabs.size() <= si) {
+			if (end) return *this;
+			ci = sm->slabs[si]->next(ci+1);
+			while (ci == slabSize) {
+				if (++si >= sm->slabs.size()) {
 					end = true;
 					break;
 				}
-				if (sm->slabs[si]->used(ci)) {
-					break;
-				}
+				ci = sm->slabs[si]->count ? sm->slabs[si]->next(0): slabSize;
 			}
 			return *this;
 		}
@@ -236,24 +346,12 @@ public:
 	};
 
 	iterator begin() {
-		uint si = 0;
-		uint ci = 0;
-		bool end = false;
-		for (;;) {
-			if (ci == slabSize) {
-				ci = 0;
-				si++;
-			}
-			if (slabs.size() <= si) {
-				end = true;
-				break;
-			}
-			if (slabs[si]->used(ci)) {
-				break;
+		for (uint si = 0; si < slabs.size(); si++) {
+			if (slabs[si]->count) {
+				return iterator(this, si, slabs[si]->next(0), false);
 			}
-			ci++;
 		}
-		return iterator(this, si, ci, end);
+		return end();
 	}
 
 	iterator end() {
@@ -142,8 +142,9 @@ Spec::~Spec() {
 }
 
 Spec* Spec::byName(std::string name) {
-	ensuref(all.count(name) == 1, "unknown spec name %s", name.c_str());
-	return all[name];
+	auto it = all.find(name);
+	ensuref(it != all.end(), "unknown spec name %s", name.c_str());
+	return it->second;
 }
 
 Point Spec::aligned(Point p, Point dir) {
@@ -117,6 +117,15 @@ Store& Store::get(uint id) {
 	return all.refer(id);
 }
 
+// For the next journaled save. Activity and the promised/reserved counts
+// Store::update() rebuilds every tick don't mark a store on their own.
+// Also wakes arms and loaders sleeping until this store changes.
+void Store::changed() {
+	if (!Entity::exists(id)) return;
+	// Burner fuel stores share their entity's id
+	Entity::get(id).changed(fuel ? Save::Section::Burners: Save::Section::Stores).wake();
+}
+
 void Store::destroy() {
 	stacks.clear();
 	all.erase(id);
@@ -136,6 +145,7 @@ Stack Store::insert(Stack istack) {
 
 	if (count > 0) {
 		activity = Sim::tick;
+		changed();
 	}
 
 	for (auto it = stacks.begin(); it != stacks.end(); it++) {
@@ -163,6 +173,7 @@ Stack Store::remove(Stack rstack) {
 				it->size -= rstack.size;
 			}
 			activity = Sim::tick;
+			changed();
 			return rstack;
 		}
 	}
@@ -262,6 +273,7 @@ void Store::reserve(Stack stack) {
 }
 
 void Store::levelSet(uint iid, uint lower, uint upper, bool craft) {
+	changed();
 	Level *lvl = level(iid);
 	if (lvl) {
 		lvl->lower = lower;
@@ -278,6 +290,7 @@ void Store::levelSet(uint iid, uint lower, uint upper, bool craft) {
 }
 
 void Store::levelClear(uint iid) {
+	changed();
 	for (auto it = levels.begin(); it != levels.end(); it++) {
 		if (it->iid == iid) {
 			levels.erase(it);
@@ -68,6 +68,7 @@ struct Store {
 	void reserve(Stack stack);
 	void levelSet(uint iid, uint lower, uint upper, bool craft = false);
 	void levelClear(uint iid);
+	void changed();
 	Level* level(uint iid);
 	bool isEmpty();
 	bool isFull();
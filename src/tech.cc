@@ -36,13 +36,15 @@ Tech::~Tech() {
 }
 
 Tech* Tech::byName(std::string name) {
-	ensuref(names.count(name) == 1, "unknown tech %s", name.c_str());
-	return names[name];
+	auto it = names.find(name);
+	ensuref(it != names.end(), "unknown tech %s", name.c_str());
+	return it->second;
 }
 
 Tech* Tech::get(uint id) {
-	ensuref(ids.count(id) == 1, "unknown tech %d", id);
-	return ids[id];
+	auto it = ids.find(id);
+	ensuref(it != ids.end(), "unknown tech %d", id);
+	return it->second;
 }
 
 void Tech::buy() {
@@ -1,6 +1,6 @@
 #include "common.h"
 #include "time-series.h"
-#include "raylib-ex.h"
+#include <chrono>
 
 TimeSeries::TimeSeries() {
 	clear();
@@ -79,8 +79,15 @@ void TimeSeries::update(uint64_t t) {
 }
 
 void TimeSeries::track(uint64_t t, std::function<void(void)> fn) {
-	double start = GetTime();
-	fn();
-	set(t, (GetTime()-start)*1000.0f);
+	sample(t, fn);
 	update(t);
+}
+
+// Time fn without updating the rollups, for callers that batch update()
+void TimeSeries::sample(uint64_t t, std::function<void(void)> fn) {
+	// steady_clock rather than raylib GetTime() so headless tools work too
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	std::chrono::duration<double,std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	set(t, elapsed.count());
 }
\ No newline at end of file
@@ -57,6 +57,8 @@ void Unveyor::manage() {
 
 		if (partner) {
 			get(partner).partner = id;
+			en.changed(Save::Section::Unveyors);
+			Entity::get(partner).changed(Save::Section::Unveyors);
 			auto& send = get(entry ? id: partner);
 			send.items.clear();
 			send.items.resize((uint)dist);
@@ -69,12 +71,15 @@ void Unveyor::unmanage() {
 		Unveyor& other = get(partner);
 		ensure(other.partner == id);
 		other.partner = 0;
+		Entity::get(id).changed(Save::Section::Unveyors);
+		Entity::get(partner).changed(Save::Section::Unveyors);
 		partner = 0;
 	}
 }
 
 void Unveyor::update() {
 	if (!partner || !entry) return;
+	Entity::get(id).changed(Save::Section::Unveyors);
 
 	auto& send = Conveyor::get(id);
 	auto& recv = Conveyor::get(partner);
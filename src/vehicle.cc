@@ -3,6 +3,12 @@
 #include "sim.h"
 
 void Vehicle::reset() {
+	for (auto& vehicle: all) {
+		if (vehicle.pathRequest) {
+			Path::withdraw(vehicle.pathRequest);
+			delete vehicle.pathRequest;
+		}
+	}
 	all.clear();
 }
 
@@ -29,7 +35,7 @@ Vehicle& Vehicle::get(uint id) {
 
 void Vehicle::destroy() {
 	if (pathRequest) {
-		Path::jobs.remove(pathRequest);
+		Path::withdraw(pathRequest);
 		delete pathRequest;
 		pathRequest = NULL;
 	}
@@ -50,6 +56,7 @@ void Vehicle::update() {
 	if (en.isGhost()) return;
 	if (!en.isEnabled()) return;
 	if (handbrake || pause > Sim::tick) return;
+	en.changed(Save::Section::Vehicles);
 
 	if (path.empty() && waypoint) {
 		for (auto condition: waypoint->conditions) {
@@ -66,6 +73,12 @@ void Vehicle::update() {
 		if (pathRequest->success) {
 			notef("path success");
 
+			if (!pathRequest->recalled) {
+				PathGraph::get(pathRequest->clearance)->remember(
+					pathRequest->origin, pathRequest->target, pathRequest->result, pathRequest->since
+				);
+			}
+
 			if (waypoints.size()) {
 				waypoint = waypoints.front();
 				waypoints.pop_front();
@@ -88,6 +101,7 @@ void Vehicle::update() {
 			pause = Sim::tick + 180;
 		}
 
+		Path::withdraw(pathRequest);
 		delete pathRequest;
 		pathRequest = NULL;
 	}
@@ -176,6 +190,7 @@ Vehicle::Waypoint* Vehicle::addWaypoint(Point p) {
 	waypoints.push_back(
 		new Waypoint(p.tileCentroid())
 	);
+	Entity::get(id).changed(Save::Section::Vehicles);
 	return waypoints.back();
 }
 
@@ -186,18 +201,173 @@ Vehicle::Waypoint* Vehicle::addWaypoint(uint eid) {
 	waypoints.push_back(
 		new Waypoint(eid)
 	);
+	Entity::get(id).changed(Save::Section::Vehicles);
 	return waypoints.back();
 }
 
 Vehicle::Route::Route(Vehicle *v) : Path() {
 	vehicle = v;
+	vid = v->id;
+	Spec* spec = Entity::get(vid).spec;
+	clearance = spec->clearance;
+	costGreedy = spec->costGreedy;
+}
+
+Vehicle::Route::~Route() {
+	delete snapshot;
+}
+
+void Vehicle::Route::submit() {
+	PathGraph* graph = PathGraph::get(clearance);
+	since = PathGraph::edits;
+
+	if (graph->recall(origin, target, result)) {
+		recalled = true;
+		success = true;
+		done = true;
+		return;
+	}
+
+	if (!(PathGraph::chunkOf(origin) == PathGraph::chunkOf(target))) {
+		if (graph->search(origin, target, corridor)) {
+			for (uint i = 0; i < corridor.points.size(); i++) {
+				exits[corridor.chunks[i]] = i;
+			}
+		}
+		else
+		// both ends are open but no portal route joins them
+		if (graph->walkable(origin) && graph->walkable(target)) {
+			success = false;
+			done = true;
+			return;
+		}
+	}
+
+	Path::submit();
+}
+
+bool Vehicle::Route::inCorridor(Point p) {
+	return exits.count(PathGraph::chunkOf(p));
+}
+
+void Vehicle::Route::prepare() {
+	if (!snapshot) {
+		snapshot = new Snapshot(this);
+	}
+}
+
+bool Vehicle::Route::isLand(Box b) {
+	return snapshot ? snapshot->isLand(b): Chunk::isLandRaster(b);
+}
+
+// Boxes of entities intersecting b that a vehicle can't drive through
+void Vehicle::Route::blockers(Box b, std::vector<Box>& out) {
+	out.clear();
+	if (snapshot) {
+		snapshot->blockers(b, out);
+		return;
+	}
+	if (Chunk::vacant(b)) {
+		return;
+	}
+	for (auto eid: Entity::intersecting(b)) {
+		Entity& en = Entity::get(eid);
+		if (en.spec->vehicleStop || eid == vid) {
+			continue;
+		}
+		out.push_back(en.box());
+	}
+}
+
+// Covers the capsule getNeighbours() confines the search to, plus enough
+// margin for clearance and ray cast boxes around its edge.
+Vehicle::Route::Snapshot::Snapshot(Route* route) {
+	Point a = route->origin;
+	Point b = route->target;
+	float margin = a.distance(b) + route->clearance + 2.0f;
+
+	x0 = std::floor(std::min(a.x, b.x) - margin);
+	z0 = std::floor(std::min(a.z, b.z) - margin);
+	w = std::ceil(std::max(a.x, b.x) + margin) - x0;
+	d = std::ceil(std::max(a.z, b.z) + margin) - z0;
+
+	// a corridor bounds the search more tightly than the capsule
+	if (route->exits.size()) {
+		margin = route->clearance + 2.0f;
+		int cx0 = route->exits.begin()->first.x, cx1 = cx0;
+		int cz0 = route->exits.begin()->first.y, cz1 = cz0;
+		for (auto& [xy,_]: route->exits) {
+			cx0 = std::min(cx0, xy.x);
+			cx1 = std::max(cx1, xy.x);
+			cz0 = std::min(cz0, xy.y);
+			cz1 = std::max(cz1, xy.y);
+		}
+		x0 = std::floor(cx0*Chunk::size - margin);
+		z0 = std::floor(cz0*Chunk::size - margin);
+		w = std::ceil((cx1+1)*Chunk::size + margin) - x0;
+		d = std::ceil((cz1+1)*Chunk::size + margin) - z0;
+	}
+
+	land.resize(w*d);
+
+	auto [cx0, cz0] = Chunk::tileXYtoChunkXY(x0, z0);
+	auto [cx1, cz1] = Chunk::tileXYtoChunkXY(x0+w-1, z0+d-1);
+
+	for (int cz = cz0; cz <= cz1; cz++) {
+		for (int cx = cx0; cx <= cx1; cx++) {
+			Chunk* chunk = Chunk::tryGet(cx, cz);
+			if (!chunk) continue;
+
+			int tx0 = std::max(x0, cx*Chunk::size);
+			int tz0 = std::max(z0, cz*Chunk::size);
+			int tx1 = std::min(x0+w, (cx+1)*Chunk::size);
+			int tz1 = std::min(z0+d, (cz+1)*Chunk::size);
+
+			for (int z = tz0; z < tz1; z++) {
+				for (int x = tx0; x < tx1; x++) {
+					land[(z-z0)*w + (x-x0)] = chunk->tiles[z-cz*Chunk::size][x-cx*Chunk::size].isLand();
+				}
+			}
+		}
+	}
+
+	Box region = {(float)x0 + w*0.5f, 0.0f, (float)z0 + d*0.5f, (float)w, 1000.0f, (float)d};
+
+	for (auto eid: Entity::intersecting(region)) {
+		Entity& en = Entity::get(eid);
+		if (en.spec->vehicleStop || eid == route->vid) {
+			continue;
+		}
+		grid.insert(en.box(), boxes.size());
+		boxes.push_back(en.box());
+	}
+}
+
+// Tiles outside the snapshot count as impassable, like missing chunks
+bool Vehicle::Route::Snapshot::isLand(Box b) {
+	for (auto [x,y]: Chunk::walkTiles(b)) {
+		int ox = x-x0;
+		int oz = y-z0;
+		if (ox < 0 || oz < 0 || ox >= w || oz >= d || !land[oz*w + ox]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Vehicle::Route::Snapshot::blockers(Box b, std::vector<Box>& out) {
+	for (auto i: grid.search(b)) {
+		if (boxes[i].intersects(b)) {
+			out.push_back(boxes[i]);
+		}
+	}
 }
 
 std::vector<Point> Vehicle::Route::getNeighbours(Point p) {
 	p = p.tileCentroid();
-	float clearance = Entity::get(vehicle->id).spec->clearance;
 
-	auto entities = Entity::intersecting(p.box().grow(clearance));
+	std::vector<Box> boxes;
+	blockers(p.box().grow(clearance), boxes);
 
 	std::vector<Point> points = {
 		(p + Point( 1.0f, 0.0f, 0.0f)).tileCentroid(),
@@ -210,36 +380,29 @@ std::vector<Point> Vehicle::Route::getNeighbours(Point p) {
 		(p + Point(-1.0f, 0.0f,-1.0f)).tileCentroid(),
 	};
 
-	for (auto eid: entities) {
-		if (Entity::get(eid).spec->vehicleStop) {
-			continue;
-		}
-		if (vehicle->id != eid) {
-			Entity& en = Entity::get(eid);
-			Box box = en.box();
-			for (auto it = points.begin(); it != points.end(); ) {
-				if (*it == target) {
-					it++;
-					continue;
-				}
-				if (box.contains(*it)) {
-					points.erase(it);
-					continue;
-				}
+	for (auto box: boxes) {
+		for (auto it = points.begin(); it != points.end(); ) {
+			if (*it == target) {
 				it++;
+				continue;
 			}
+			if (box.contains(*it)) {
+				points.erase(it);
+				continue;
+			}
+			it++;
 		}
 	}
 
 	float range = origin.distance(target);
 
 	for (auto it = points.begin(); it != points.end(); ) {
-		if (!Chunk::isLand(it->box().grow(clearance))) {
+		if (!isLand(it->box().grow(clearance))) {
 			points.erase(it);
 			continue;
 		}
-		// capsule shaped range limit
-		if ((*it).lineDistance(origin, target) > range) {
+		// corridor, or capsule shaped range limit
+		if (exits.size() ? !inCorridor(*it): (*it).lineDistance(origin, target) > range) {
 			points.erase(it);
 			continue;
 		}
@@ -260,54 +423,52 @@ std::vector<Point> Vehicle::Route::getNeighbours(Point p) {
 }
 
 double Vehicle::Route::calcCost(Point a, Point b) {
-	float clearance = Entity::get(vehicle->id).spec->clearance;
 	float cost = a.distance(b);
 
 	if (b == target || b.distance(target) < clearance*1.5f) {
 		return cost;
 	}
 
-	if (!Chunk::isLand(b.box().grow(clearance))) {
+	if (!isLand(b.box().grow(clearance))) {
 		cost *= 1000.0f;
 	}
 
-	auto entities = Entity::intersecting(b.box().grow(clearance, 0, clearance));
+	std::vector<Box> boxes;
+	blockers(b.box().grow(clearance, 0, clearance), boxes);
 
-	for (auto eid: entities) {
-		if (Entity::get(eid).spec->vehicleStop) {
-			continue;
-		}
-		if (vehicle->id != eid) {
-			cost *= 5.0f;
-		}
+	for (uint i = 0; i < boxes.size(); i++) {
+		cost *= 5.0f;
 	}
 
 	return cost;
 }
 
 double Vehicle::Route::calcHeuristic(Point p) {
-	return p.distance(target) * Entity::get(vehicle->id).spec->costGreedy;
+	if (exits.size()) {
+		auto it = exits.find(PathGraph::chunkOf(p));
+		if (it != exits.end()) {
+			uint i = it->second;
+			return (p.distance(corridor.points[i]) + corridor.remaining[i]) * costGreedy;
+		}
+	}
+	return p.distance(target) * costGreedy;
 }
 
 bool Vehicle::Route::rayCast(Point a, Point b) {
-	float clearance = Entity::get(vehicle->id).spec->clearance;
-
 	float d = a.distance(b);
 	if (d > 32.0f) return false;
 
 	Point n = (b-a).normalize();
 
+	std::vector<Box> boxes;
+
 	for (Point c = a; c.distance(b) > 1.0f; c += n) {
-		if (!Chunk::isLand(c.box().grow(clearance))) {
+		if (!isLand(c.box().grow(clearance))) {
 			return false;
 		}
-		for (auto eid: Entity::intersecting(c.box().grow(1))) {
-			if (Entity::get(eid).spec->vehicleStop) {
-				continue;
-			}
-			if (vehicle->id != eid) {
-				return false;
-			}
+		blockers(c.box().grow(1), boxes);
+		if (boxes.size()) {
+			return false;
 		}
 	}
 
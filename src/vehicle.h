@@ -8,6 +8,7 @@ struct Vehicle;
 
 #include "entity.h"
 #include "path.h"
+#include "path-graph.h"
 #include <list>
 #include <vector>
 
@@ -15,12 +16,48 @@ struct Vehicle {
 	uint id;
 
 	struct Route: Path {
+		// Read-only copy of the land and obstacles within a route's range,
+		// taken on the sim thread so the search can run on the path worker.
+		struct Snapshot {
+			int x0, z0, w, d;
+			std::vector<bool> land;
+			std::vector<Box> boxes;
+			gridmap<16,uint> grid;
+
+			Snapshot(Route*);
+			bool isLand(Box b);
+			void blockers(Box b, std::vector<Box>& out);
+		};
+
 		Vehicle *vehicle;
+		// copied so a background search never touches the vehicle
+		uint vid;
+		float clearance;
+		float costGreedy;
+		Snapshot* snapshot = nullptr;
+
+		// Routes crossing chunks search the PathGraph first, then refine
+		// only within the corridor's chunks, using the portal route for the
+		// heuristic. exits maps each chunk to its last corridor point.
+		PathGraph::Corridor corridor;
+		std::map<PathGraph::XY,uint> exits;
+
+		// PathGraph::edits at submit, and whether the route cache answered
+		uint64_t since = 0;
+		bool recalled = false;
+
 		Route(Vehicle*);
+		~Route();
+		virtual void submit();
+		virtual void prepare();
 		virtual std::vector<Point> getNeighbours(Point);
 		virtual double calcCost(Point,Point);
 		virtual double calcHeuristic(Point);
 		virtual bool rayCast(Point,Point);
+
+		bool isLand(Box b);
+		void blockers(Box b, std::vector<Box>& out);
+		bool inCorridor(Point p);
 	};
 
 	struct Waypoint;
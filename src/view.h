@@ -37,6 +37,7 @@ struct SiteCamera : View {
 	Point dir;
 	std::vector<GuiEntity*> entities;
 	uint64_t refresh;
+	uint64_t frame;
 
 	SiteCamera(Point, Point);
 	~SiteCamera();
@@ -97,6 +98,14 @@ struct MainCamera : View {
 	std::vector<GuiEntity*> hovered;
 	std::vector<GuiEntity*> selected;
 
+	// first pathfinding job, copied under the sim lock for the debug overlay
+	struct {
+		bool shown = false;
+		Point target;
+		std::vector<Point> open;
+		std::vector<Point> closed;
+	} path;
+
 	float buildLevel;
 
 	TimeSeries statsUpdate;
@@ -0,0 +1,119 @@
+#include "common.h"
+#include "wake-queue.h"
+#include <algorithm>
+
+void WakeQueue::clear() {
+	state.clear();
+	watchers.clear();
+	awake.clear();
+	woken.clear();
+	slept.clear();
+	for (auto& slot: wheel) {
+		slot.clear();
+	}
+	now = 0;
+}
+
+void WakeQueue::insert(uint id) {
+	state[id] = 0;
+	woken.push_back(id);
+}
+
+void WakeQueue::remove(uint id) {
+	// stale entries on the wheel are skipped by ready()
+	state.erase(id);
+	slept.push_back(id);
+}
+
+void WakeQueue::wake(uint id) {
+	if (watchers.size()) {
+		auto wit = watchers.find(id);
+		if (wit != watchers.end()) {
+			auto ids = std::move(wit->second);
+			watchers.erase(wit);
+			for (uint wid: ids) wake(wid);
+		}
+	}
+
+	auto it = state.find(id);
+	if (it == state.end() || !it->second) return;
+	it->second = 0;
+	woken.push_back(id);
+}
+
+void WakeQueue::watch(uint id, uint on) {
+	if (!on || on == id) return;
+	auto& ids = watchers[on];
+	if (!contains(ids, id)) {
+		ids.push_back(id);
+	}
+}
+
+void WakeQueue::sleep(uint id) {
+	auto it = state.find(id);
+	if (it == state.end()) return;
+	it->second = Forever;
+	slept.push_back(id);
+}
+
+void WakeQueue::sleep(uint id, uint64_t until) {
+	auto it = state.find(id);
+	if (it == state.end()) return;
+	until = std::max(until, now+1);
+	it->second = until;
+	wheel[until%Slots].push_back({id, until});
+	slept.push_back(id);
+}
+
+bool WakeQueue::sleeping(uint id) {
+	auto it = state.find(id);
+	return it != state.end() && it->second;
+}
+
+const std::vector<uint>& WakeQueue::ready(uint64_t tick) {
+	now = tick;
+
+	auto& slot = wheel[tick%Slots];
+	uint keep = 0;
+
+	for (auto& timer: slot) {
+		auto it = state.find(timer.id);
+		if (it == state.end() || it->second != timer.until) continue;
+		if (timer.until > tick) {
+			slot[keep++] = timer;
+			continue;
+		}
+		it->second = 0;
+		woken.push_back(timer.id);
+	}
+	slot.resize(keep);
+
+	// awake is still sorted from last time; drop whatever slept or was
+	// removed since, then merge in whatever woke and is still awake
+	if (slept.size()) {
+		deduplicate(slept);
+		uint kept = 0, s = 0;
+		for (uint id: awake) {
+			while (s < slept.size() && slept[s] < id) s++;
+			if (s < slept.size() && slept[s] == id) continue;
+			awake[kept++] = id;
+		}
+		awake.resize(kept);
+		slept.clear();
+	}
+
+	if (woken.size()) {
+		deduplicate(woken);
+		discard_if(woken, [&](uint id) {
+			auto it = state.find(id);
+			return it == state.end() || it->second;
+		});
+		uint mid = awake.size();
+		awake.insert(awake.end(), woken.begin(), woken.end());
+		std::inplace_merge(awake.begin(), awake.begin()+mid, awake.end());
+		awake.erase(std::unique(awake.begin(), awake.end()), awake.end());
+		woken.clear();
+	}
+
+	return awake;
+}
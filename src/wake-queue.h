@@ -0,0 +1,44 @@
+#pragma once
+
+// A WakeQueue lets a component system skip idle instances. Instances are
+// awake by default and visited every tick. sleep(id, until) parks one on a
+// timer wheel until a tick; sleep(id) parks it until something calls
+// wake(id), such as the entity being enabled. watch(id, on) also wakes id
+// the next time wake(on) is called, so an arm can sleep until a neighbouring
+// store changes.
+// ready() returns the awake ids in ascending order so that iteration stays
+// deterministic. The list stays sorted between ticks; only the ids that
+// slept, woke or were removed since the last call are sorted and merged.
+
+#include <vector>
+#include <unordered_map>
+
+struct WakeQueue {
+	static const uint Slots = 256;
+	static const uint64_t Forever = ~0ULL;
+
+	struct Timer {
+		uint id;
+		uint64_t until;
+	};
+
+	// id -> 0 when awake, else the tick it sleeps until
+	std::unordered_map<uint,uint64_t> state;
+	// id -> ids to wake along with it, once
+	std::unordered_map<uint,std::vector<uint>> watchers;
+	std::vector<uint> awake;
+	std::vector<uint> woken;
+	std::vector<uint> slept;
+	std::vector<Timer> wheel[Slots];
+	uint64_t now = 0;
+
+	void clear();
+	void insert(uint id);
+	void remove(uint id);
+	void wake(uint id);
+	void watch(uint id, uint on);
+	void sleep(uint id);
+	void sleep(uint id, uint64_t until);
+	bool sleeping(uint id);
+	const std::vector<uint>& ready(uint64_t tick);
+};